@@ -3,6 +3,27 @@
 #include <ctime>
 #include <sstream>
 #include <stdexcept>
+#include <climits>
+#include <cstdio>
+#include <cstdint>
+#include <cerrno>
+#include <cstring>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+#if __cplusplus >= 202002L && __has_include(<coroutine>)
+#include <coroutine>
+#include <atomic>
+#include <optional>
+#include <exception>
+#define GITLET_HAS_COROUTINES 1
+#endif
 
 unsigned long simpleHash(const std::string &str)
 {
@@ -22,6 +43,127 @@ std::string hashToString(unsigned long hash)
     return ss.str();
 }
 
+// CRC-32 (IEEE polynomial) used to checksum log records and bundles.
+// crc32Update continues a running checksum; start it from 0.
+uint32_t crc32Update(uint32_t previous, const char *data, size_t length)
+{
+    static uint32_t table[256];
+    static bool tableReady = false;
+    if (!tableReady)
+    {
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k)
+            {
+                c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+            }
+            table[i] = c;
+        }
+        tableReady = true;
+    }
+
+    uint32_t crc = previous ^ 0xFFFFFFFFu;
+    for (size_t i = 0; i < length; ++i)
+    {
+        crc = table[(crc ^ (unsigned char)data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+uint32_t crc32(const char *data, size_t length)
+{
+    return crc32Update(0, data, length);
+}
+
+// --- Binary encoding helpers (little-endian, length-prefixed strings) ---
+
+void appendU32(std::string &out, uint32_t value)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        out.push_back((char)((value >> (8 * i)) & 0xFF));
+    }
+}
+
+void appendU64(std::string &out, uint64_t value)
+{
+    for (int i = 0; i < 8; ++i)
+    {
+        out.push_back((char)((value >> (8 * i)) & 0xFF));
+    }
+}
+
+void appendString(std::string &out, const std::string &value)
+{
+    appendU32(out, (uint32_t)value.size());
+    out += value;
+}
+
+struct ByteReader
+{
+    const std::string &data;
+    size_t pos;
+    bool ok;
+
+    ByteReader(const std::string &d) : data(d), pos(0), ok(true) {}
+
+    unsigned char readU8()
+    {
+        if (!ok || data.size() - pos < 1)
+        {
+            ok = false;
+            return 0;
+        }
+        return (unsigned char)data[pos++];
+    }
+
+    uint32_t readU32()
+    {
+        if (!ok || data.size() - pos < 4)
+        {
+            ok = false;
+            return 0;
+        }
+        uint32_t value = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            value |= (uint32_t)(unsigned char)data[pos + i] << (8 * i);
+        }
+        pos += 4;
+        return value;
+    }
+
+    uint64_t readU64()
+    {
+        if (!ok || data.size() - pos < 8)
+        {
+            ok = false;
+            return 0;
+        }
+        uint64_t value = 0;
+        for (int i = 0; i < 8; ++i)
+        {
+            value |= (uint64_t)(unsigned char)data[pos + i] << (8 * i);
+        }
+        pos += 8;
+        return value;
+    }
+
+    std::string readString()
+    {
+        uint32_t length = readU32();
+        if (!ok || data.size() - pos < length)
+        {
+            ok = false;
+            return "";
+        }
+        std::string value = data.substr(pos, length);
+        pos += length;
+        return value;
+    }
+};
+
 template <typename T>
 class SimpleVec
 {
@@ -166,7 +308,177 @@ void bubbleSort(SimpleVec<std::string> &vec)
     } while (swapped);
 }
 
-template <typename K, typename V>
+// Stable merge sort for element types bubbleSort does not cover;
+// less(a, b) must return true when a orders before b.
+template <typename T, typename Less>
+void mergeSort(SimpleVec<T> &vec, Less less)
+{
+    size_t n = vec.size();
+    if (n < 2)
+    {
+        return;
+    }
+    SimpleVec<T> scratch = vec;
+    for (size_t width = 1; width < n; width *= 2)
+    {
+        for (size_t lo = 0; lo < n; lo += 2 * width)
+        {
+            size_t mid = lo + width < n ? lo + width : n;
+            size_t hi = lo + 2 * width < n ? lo + 2 * width : n;
+            size_t i = lo, j = mid, k = lo;
+            while (i < mid && j < hi)
+                scratch[k++] = less(vec[j], vec[i]) ? vec[j++] : vec[i++];
+            while (i < mid)
+                scratch[k++] = vec[i++];
+            while (j < hi)
+                scratch[k++] = vec[j++];
+        }
+        for (size_t i = 0; i < n; ++i)
+        {
+            vec[i] = scratch[i];
+        }
+    }
+}
+
+// --- Key traits and hash policies ---
+// The maps below take a hash policy (static hash(key)) and a key traits
+// policy (static equal(a, b)); KeyTraits<K>::Hash is a key type's default.
+
+// Generic string hash; the default for string keys.
+struct StringHash
+{
+    static size_t hash(const std::string &key)
+    {
+        return simpleHash(key);
+    }
+};
+
+// Paths share long prefixes ("src/module/..."), so this hash consumes eight
+// bytes per step instead of one.
+struct PathHash
+{
+    static size_t hash(const std::string &key)
+    {
+        uint64_t h = 0x9E3779B97F4A7C15ULL ^ key.size();
+        size_t i = 0;
+        for (; i + 8 <= key.size(); i += 8)
+        {
+            uint64_t word;
+            std::memcpy(&word, key.data() + i, 8);
+            h = (h ^ word) * 0xFF51AFD7ED558CCDULL;
+            h ^= h >> 32;
+        }
+        uint64_t tail = 0;
+        std::memcpy(&tail, key.data() + i, key.size() - i);
+        h = (h ^ tail) * 0xFF51AFD7ED558CCDULL;
+        return (size_t)(h ^ (h >> 29));
+    }
+};
+
+// Hex digit values ('0'-'9', 'a'-'f'), -1 for anything else.
+struct HexDigits
+{
+    signed char value[256];
+    constexpr HexDigits() : value()
+    {
+        for (int c = 0; c < 256; ++c)
+            value[c] = -1;
+        for (int c = '0'; c <= '9'; ++c)
+            value[c] = (signed char)(c - '0');
+        for (int c = 'a'; c <= 'f'; ++c)
+            value[c] = (signed char)(c - 'a' + 10);
+    }
+};
+static constexpr HexDigits HEX_DIGITS{};
+
+// Binary form of an object ID (commit ID or content hash): the 64-bit hash
+// itself, stored inline instead of as a 16-character heap string.
+struct ObjectId
+{
+    unsigned char bytes[8]; // the hash value in host byte order (never serialized)
+
+    // Accepts only the canonical hashToString() form, so toHex() round-trips.
+    static bool fromHex(const std::string &hex, ObjectId &id)
+    {
+        if (hex.empty() || hex.size() > 16 || (hex[0] == '0' && hex.size() > 1))
+        {
+            return false;
+        }
+        // Branch-free digit loop: validity is checked once at the end.
+        uint64_t value = 0;
+        int invalid = 0;
+        for (char c : hex)
+        {
+            int digit = HEX_DIGITS.value[(unsigned char)c];
+            invalid |= digit;
+            value = (value << 4) | (uint64_t)(digit & 0xF);
+        }
+        if (invalid < 0)
+        {
+            return false;
+        }
+        std::memcpy(id.bytes, &value, sizeof(value)); // one store, so hashing can forward it
+        return true;
+    }
+
+    std::string toHex() const
+    {
+        uint64_t value;
+        std::memcpy(&value, bytes, sizeof(value));
+        return hashToString((unsigned long)value);
+    }
+
+    bool operator==(const ObjectId &other) const
+    {
+        return std::memcmp(bytes, other.bytes, sizeof(bytes)) == 0;
+    }
+
+    bool operator!=(const ObjectId &other) const
+    {
+        return !(*this == other);
+    }
+};
+
+// IDs are already hashes, so their first 8 bytes are the hash. One multiply
+// folds simpleHash's weak low bits into the bucket index.
+struct ObjectIdHash
+{
+    static size_t hash(const ObjectId &id)
+    {
+        uint64_t value;
+        std::memcpy(&value, id.bytes, 8);
+        value *= 0x9E3779B97F4A7C15ULL;
+        return (size_t)(value ^ (value >> 32));
+    }
+};
+
+template <typename K>
+struct KeyTraits
+{
+    static_assert(sizeof(K) == 0, "no KeyTraits specialization for this key type");
+};
+
+template <>
+struct KeyTraits<std::string>
+{
+    typedef StringHash Hash;
+    static bool equal(const std::string &a, const std::string &b)
+    {
+        return a == b;
+    }
+};
+
+template <>
+struct KeyTraits<ObjectId>
+{
+    typedef ObjectIdHash Hash;
+    static bool equal(const ObjectId &a, const ObjectId &b)
+    {
+        return a == b;
+    }
+};
+
+template <typename K, typename V, typename Hash = typename KeyTraits<K>::Hash, typename Traits = KeyTraits<K>>
 class SimpleMap
 {
 private:
@@ -187,15 +499,7 @@ private:
 
     size_t hashFn(const K &key) const
     {
-        if constexpr (std::is_same<K, std::string>::value)
-        {
-            return simpleHash(key) % numBuckets;
-        }
-        else
-        {
-            static_assert(std::is_same<K, std::string>::value, "SimpleMap only supports string keys in this example");
-            return 0;
-        }
+        return Hash::hash(key) % numBuckets;
     }
     void resize()
     {
@@ -295,7 +599,7 @@ public:
         Node *current = head;
         while (current != nullptr)
         {
-            if (current->key == key)
+            if (Traits::equal(current->key, key))
             {
                 current->value = value;
                 return;
@@ -314,7 +618,7 @@ public:
         Node *current = buckets[bucketIndex];
         while (current != nullptr)
         {
-            if (current->key == key)
+            if (Traits::equal(current->key, key))
             {
                 return &(current->value);
             }
@@ -328,7 +632,7 @@ public:
         Node *current = buckets[bucketIndex];
         while (current != nullptr)
         {
-            if (current->key == key)
+            if (Traits::equal(current->key, key))
             {
                 return &(current->value);
             }
@@ -350,7 +654,7 @@ public:
 
         while (current != nullptr)
         {
-            if (current->key == key)
+            if (Traits::equal(current->key, key))
             {
                 if (prev == nullptr)
                 {
@@ -412,443 +716,4237 @@ public:
     };
 };
 
-struct Commit
-{
-    std::string id;
-    std::string message;
-    long timestamp;
-    std::string parentId;
-    SimpleMap<std::string, std::string> trackedFiles;
-    Commit() : timestamp(0) {}
-};
-
-class Gitlet
+// Map that keeps up to N entries in inline arrays, with no heap allocation
+// of its own and lookups by linear scan, and moves them into a SimpleMap
+// once it outgrows them.
+template <typename K, typename V, size_t N, typename Hash = typename KeyTraits<K>::Hash, typename Traits = KeyTraits<K>>
+class InlineFlatMap
 {
 private:
-    bool initialized;
-    SimpleMap<std::string, std::string> stagingArea; // filename -> contentHash
-    SimpleMap<std::string, std::string> objectStore; // contentHash -> content
-    SimpleMap<std::string, Commit> commits;          // commitId -> Commit object
-    std::string headCommitId;
+    K keys[N];
+    V values[N];
+    size_t count;                         // inline entries; unused once spilled
+    SimpleMap<K, V, Hash, Traits> *spill; // all entries, once there are more than N
 
-    std::string generateCommitId(const Commit &commit)
+    size_t indexOf(const K &key) const
     {
-        std::stringstream dataStream;
-        dataStream << commit.message << commit.timestamp << commit.parentId;
-
-        // Get keys, sort them, then access values for hashing
-        SimpleVec<std::string> sortedFilenames = commit.trackedFiles.getKeys();
-        bubbleSort(sortedFilenames); // Use our simple sort
-
-        for (size_t i = 0; i < sortedFilenames.size(); ++i)
+        for (size_t i = 0; i < count; ++i)
         {
-            const std::string &fname = sortedFilenames[i];
-            const std::string *contentHashPtr = commit.trackedFiles.find(fname); // find returns pointer
-            if (contentHashPtr)
-            { // Should always be found if key came from getKeys
-                dataStream << fname << *contentHashPtr;
-            }
-            else
+            if (Traits::equal(keys[i], key))
             {
-                // This indicates an internal error
-                std::cerr << "Error: Key found in getKeys but not in find during hash generation for " << fname << std::endl;
+                return i;
             }
         }
-
-        return hashToString(simpleHash(dataStream.str()));
+        return N;
     }
 
-    Commit *getHeadCommit()
-    {
-        if (headCommitId.empty())
-            return nullptr;
-        return commits.find(headCommitId); // find returns pointer, null if not found
-    }
-
-    Commit *getCommit(const std::string &commitId)
+    void copyFrom(const InlineFlatMap &other)
     {
-        return commits.find(commitId); // find returns pointer, null if not found
+        count = other.count;
+        for (size_t i = 0; i < count; ++i)
+        {
+            keys[i] = other.keys[i];
+            values[i] = other.values[i];
+        }
+        spill = other.spill ? new SimpleMap<K, V, Hash, Traits>(*other.spill) : nullptr;
     }
 
 public:
-    Gitlet() : initialized(false) {}
+    static constexpr size_t INLINE_CAPACITY = N;
 
-    // --- Core Commands ---
+    InlineFlatMap() : count(0), spill(nullptr) {}
 
-    void init()
+    InlineFlatMap(const InlineFlatMap &other)
     {
-        if (initialized)
+        copyFrom(other);
+    }
+
+    InlineFlatMap &operator=(const InlineFlatMap &other)
+    {
+        if (this != &other)
         {
-            std::cout << "Repository already initialized." << std::endl;
-            return;
+            delete spill;
+            copyFrom(other);
         }
-        commits.clear(); // Ensure clean state
-        stagingArea.clear();
-        objectStore.clear();
-
-        Commit initialCommit;
-        initialCommit.message = "initial commit";
-        initialCommit.timestamp = std::time(nullptr);
-        initialCommit.parentId = "";
-        // trackedFiles is empty by default constructor of SimpleMap
-
-        initialCommit.id = generateCommitId(initialCommit);
-
-        // Insert the Commit object (requires Commit copyability)
-        commits.insert(initialCommit.id, initialCommit);
-
-        headCommitId = initialCommit.id;
-        initialized = true;
+        return *this;
+    }
 
-        std::cout << "Initialized empty Gitlet repository." << std::endl;
-        std::cout << "Initial commit ID: " << headCommitId << std::endl;
+    ~InlineFlatMap()
+    {
+        delete spill;
     }
 
-    void add(const std::string &filename, const std::string &content)
+    void insert(const K &key, const V &value)
     {
-        if (!initialized)
+        if (spill)
         {
-            std::cout << "Error: Repository not initialized. Run 'init' first." << std::endl;
+            spill->insert(key, value);
             return;
         }
-
-        std::string contentHash = hashToString(simpleHash(content));
-
-        // Store blob if new
-        if (!objectStore.contains(contentHash))
+        size_t i = indexOf(key);
+        if (i < N)
         {
-            objectStore.insert(contentHash, content);
+            values[i] = value;
+            return;
         }
-
-        // Check if identical to version in HEAD commit
-        Commit *head = getHeadCommit();
-        bool identicalToHead = false;
-        if (head)
+        if (count < N)
         {
-            const std::string *headContentHashPtr = head->trackedFiles.find(filename);
-            if (headContentHashPtr && *headContentHashPtr == contentHash)
-            {
-                identicalToHead = true;
-            }
+            keys[count] = key;
+            values[count] = value;
+            count++;
+            return;
         }
+        spill = new SimpleMap<K, V, Hash, Traits>();
+        for (size_t j = 0; j < count; ++j)
+        {
+            spill->insert(keys[j], values[j]);
+            keys[j] = K();
+            values[j] = V();
+        }
+        count = 0;
+        spill->insert(key, value);
+    }
 
-        // Check staging area
-        const std::string *stagedContentHashPtr = stagingArea.find(filename);
-
-        // If identical to head, remove from staging
-        if (identicalToHead)
+    V *find(const K &key)
+    {
+        if (spill)
         {
-            if (stagedContentHashPtr)
-            { // Only remove if it was actually staged
-                stagingArea.remove(filename);
-                // std::cout << "Debug: Unstaged '" << filename << "' as it matches HEAD." << std::endl;
-            }
+            return spill->find(key);
         }
-        else
+        size_t i = indexOf(key);
+        return i < N ? &values[i] : nullptr;
+    }
+
+    const V *find(const K &key) const
+    {
+        if (spill)
         {
-            // Stage the file: filename -> contentHash
-            // Only print message if it's a new staging or different content
-            if (!stagedContentHashPtr || *stagedContentHashPtr != contentHash)
-            {
-                stagingArea.insert(filename, contentHash);
-                std::cout << "Staged '" << filename << "' for commit." << std::endl;
-            }
-            else
-            {
-                // std::cout << "Debug: File '" << filename << "' already staged with this content." << std::endl;
-            }
+            return spill->find(key);
         }
+        size_t i = indexOf(key);
+        return i < N ? &values[i] : nullptr;
     }
 
-    void commit(const std::string &message)
+    bool contains(const K &key) const
     {
-        if (!initialized)
+        return find(key) != nullptr;
+    }
+
+    bool remove(const K &key)
+    {
+        if (spill)
         {
-            std::cout << "Error: Repository not initialized. Run 'init' first." << std::endl;
-            return;
+            return spill->remove(key);
         }
-        if (stagingArea.empty())
+        size_t i = indexOf(key);
+        if (i == N)
         {
-            std::cout << "Nothing to commit, staging area is empty." << std::endl;
-            return;
+            return false;
+        }
+        count--;
+        keys[i] = keys[count];
+        values[i] = values[count];
+        keys[count] = K();
+        values[count] = V();
+        return true;
+    }
+
+    void clear()
+    {
+        delete spill;
+        spill = nullptr;
+        for (size_t i = 0; i < count; ++i)
+        {
+            keys[i] = K();
+            values[i] = V();
+        }
+        count = 0;
+    }
+
+    size_t size() const
+    {
+        return spill ? spill->size() : count;
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    SimpleVec<K> getKeys() const
+    {
+        if (spill)
+        {
+            return spill->getKeys();
+        }
+        SimpleVec<K> result;
+        for (size_t i = 0; i < count; ++i)
+        {
+            result.push_back(keys[i]);
+        }
+        return result;
+    }
+};
+
+// filename -> content hash. Most commits track a handful of files, so their
+// manifests stay inline; larger ones spill into a path-hashed SimpleMap.
+// Hashes are binary, so a short path is the only string an entry holds.
+static constexpr size_t MANIFEST_INLINE_FILES = 8;
+typedef InlineFlatMap<std::string, ObjectId, MANIFEST_INLINE_FILES, PathHash> Manifest;
+
+struct Commit
+{
+    std::string id;
+    std::string message;
+    long timestamp;
+    std::string parentId;
+    Manifest trackedFiles;
+    Commit() : timestamp(0) {}
+};
+
+// Per-commit Bloom filter over the paths a commit changed relative to its
+// parent, plus every directory prefix of those paths. A negative answer is
+// exact, so history walks can skip the commit without loading its manifest.
+// A commit with no filter (or one that changed too many paths) answers
+// "maybe" for everything.
+class BloomFilter
+{
+private:
+    static const size_t BITS_PER_ENTRY = 10;
+    static const size_t NUM_HASHES = 7;
+    static const size_t MAX_ENTRIES = 512;
+
+    std::string bits;
+    bool present;
+
+    static uint64_t secondHash(const std::string &key)
+    {
+        uint64_t hash = 14695981039346656037ull; // FNV-1a
+        for (char c : key)
+        {
+            hash ^= (unsigned char)c;
+            hash *= 1099511628211ull;
+        }
+        return hash | 1;
+    }
+
+public:
+    BloomFilter() : present(false) {}
+
+    static void addPathAndParents(const std::string &path, SimpleVec<std::string> &out)
+    {
+        out.push_back(path);
+        for (size_t slash = path.rfind('/'); slash != std::string::npos && slash > 0; slash = path.rfind('/', slash - 1))
+        {
+            out.push_back(path.substr(0, slash));
+        }
+    }
+
+    static BloomFilter build(const SimpleVec<std::string> &changedPaths)
+    {
+        SimpleVec<std::string> keys;
+        for (size_t i = 0; i < changedPaths.size(); ++i)
+        {
+            addPathAndParents(changedPaths[i], keys);
+        }
+        BloomFilter filter;
+        if (keys.size() > MAX_ENTRIES)
+        {
+            return filter; // too broad to be useful: always "maybe"
+        }
+        filter.present = true;
+        size_t numBits = keys.size() * BITS_PER_ENTRY;
+        numBits = numBits < 64 ? 64 : (numBits + 7) / 8 * 8;
+        filter.bits.assign(keys.empty() ? 0 : numBits / 8, '\0');
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            filter.add(keys[i]);
+        }
+        return filter;
+    }
+
+    void add(const std::string &key)
+    {
+        size_t numBits = bits.size() * 8;
+        uint64_t h1 = simpleHash(key);
+        uint64_t h2 = secondHash(key);
+        for (size_t i = 0; i < NUM_HASHES; ++i)
+        {
+            size_t bit = (size_t)((h1 + i * h2) % numBits);
+            bits[bit / 8] |= (char)(1 << (bit % 8));
+        }
+    }
+
+    bool mightContain(const std::string &key) const
+    {
+        if (!present)
+        {
+            return true;
+        }
+        size_t numBits = bits.size() * 8;
+        if (numBits == 0)
+        {
+            return false; // commit changed nothing
+        }
+        uint64_t h1 = simpleHash(key);
+        uint64_t h2 = secondHash(key);
+        for (size_t i = 0; i < NUM_HASHES; ++i)
+        {
+            size_t bit = (size_t)((h1 + i * h2) % numBits);
+            if (!(bits[bit / 8] & (1 << (bit % 8))))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void serialize(std::string &out) const
+    {
+        out.push_back(present ? 1 : 0);
+        appendString(out, bits);
+    }
+
+    bool deserialize(ByteReader &reader)
+    {
+        present = reader.readU8() != 0;
+        bits = reader.readString();
+        return reader.ok;
+    }
+};
+
+// Lightweight per-commit node kept separately from the (much larger) commit
+// manifest, so history can be walked without loading trees.
+struct CommitGraphEntry
+{
+    ObjectId parentId; // only meaningful when hasParent
+    bool hasParent;    // false for a root or a shallow root
+    long timestamp;
+    BloomFilter changedPaths;
+    CommitGraphEntry() : parentId(), hasParent(false), timestamp(0) {}
+
+    // Takes a hex parent ID ("" for none); false if it is not a valid ID.
+    bool setParent(const std::string &parentHex)
+    {
+        hasParent = !parentHex.empty() && ObjectId::fromHex(parentHex, parentId);
+        return hasParent || parentHex.empty();
+    }
+
+    std::string parentHex() const
+    {
+        return hasParent ? parentId.toHex() : std::string();
+    }
+};
+
+std::string serializeCommit(const Commit &commit)
+{
+    std::string out;
+    appendString(out, commit.id);
+    appendString(out, commit.parentId);
+    appendU64(out, (uint64_t)commit.timestamp);
+    appendString(out, commit.message);
+
+    SimpleVec<std::string> filenames = commit.trackedFiles.getKeys();
+    appendU32(out, (uint32_t)filenames.size());
+    for (size_t i = 0; i < filenames.size(); ++i)
+    {
+        appendString(out, filenames[i]);
+        appendString(out, commit.trackedFiles.find(filenames[i])->toHex());
+    }
+    return out;
+}
+
+bool deserializeCommit(const std::string &payload, Commit &commit)
+{
+    ByteReader reader(payload);
+    commit.id = reader.readString();
+    commit.parentId = reader.readString();
+    commit.timestamp = (long)reader.readU64();
+    commit.message = reader.readString();
+
+    uint32_t fileCount = reader.readU32();
+    commit.trackedFiles.clear();
+    for (uint32_t i = 0; i < fileCount && reader.ok; ++i)
+    {
+        std::string filename = reader.readString();
+        ObjectId contentHash;
+        if (!ObjectId::fromHex(reader.readString(), contentHash))
+        {
+            return false;
+        }
+        if (reader.ok)
+        {
+            commit.trackedFiles.insert(filename, contentHash);
+        }
+    }
+    return reader.ok;
+}
+
+// Append-only log of repository mutations. Every record is framed as
+// [u32 payload length][u32 crc32 of type+payload][u8 type][payload], so a torn
+// or corrupted tail left behind by a crash is detected and cut off on replay.
+class WriteAheadLog
+{
+public:
+    static const char RECORD_OBJECT = 'O'; // contentHash, content
+    static const char RECORD_COMMIT = 'C'; // serialized Commit
+    static const char RECORD_HEAD = 'H';   // commitId HEAD moved to
+    static const char RECORD_GRAPH = 'G';  // commitId, CommitGraphEntry
+
+private:
+    static const size_t FRAME_HEADER = 9;
+
+    // Sequential read-ahead buffer so a scan costs one pread per 64 KiB
+    // instead of several per record.
+    struct ReadWindow
+    {
+        int fd;
+        std::string buffer;
+        uint64_t start;
+
+        ReadWindow(int f) : fd(f), start(0) {}
+
+        bool read(uint64_t offset, size_t count, std::string &out)
+        {
+            if (offset < start || offset + count > start + buffer.size())
+            {
+                size_t want = count > 65536 ? count : 65536;
+                buffer.resize(want);
+                size_t got = 0;
+                while (got < want)
+                {
+                    ssize_t n = ::pread(fd, &buffer[got], want - got, (off_t)(offset + got));
+                    if (n < 0 && errno == EINTR)
+                        continue;
+                    if (n <= 0)
+                        break;
+                    got += (size_t)n;
+                }
+                buffer.resize(got);
+                start = offset;
+                if (got < count)
+                {
+                    return false;
+                }
+            }
+            out.assign(buffer, (size_t)(offset - start), count);
+            return true;
+        }
+    };
+
+    int fd;
+    uint64_t length;      // bytes of valid records in the log
+    uint64_t syncedLength; // bytes known to be on stable storage
+    uint64_t discarded;    // bytes of torn tail cut off by the last scan
+    bool prefixDamaged;    // the last scan hit a bad frame inside the trusted prefix
+    bool readOnly;         // opened with openReadOnly(): never written
+    std::string error;
+
+    bool fail(const char *what)
+    {
+        error = std::string(what) + ": " + std::strerror(errno);
+        return false;
+    }
+
+public:
+    WriteAheadLog() : fd(-1), length(0), syncedLength(0), discarded(0), prefixDamaged(false), readOnly(false) {}
+
+    WriteAheadLog(const WriteAheadLog &) = delete;
+    WriteAheadLog &operator=(const WriteAheadLog &) = delete;
+
+    ~WriteAheadLog()
+    {
+        close();
+    }
+
+    bool isOpen() const
+    {
+        return fd >= 0;
+    }
+
+    uint64_t size() const
+    {
+        return length;
+    }
+
+    uint64_t durableSize() const
+    {
+        return syncedLength;
+    }
+
+    uint64_t discardedBytes() const
+    {
+        return discarded;
+    }
+
+    bool damagedBeforeTrustedPrefix() const
+    {
+        return prefixDamaged;
+    }
+
+    const std::string &lastError() const
+    {
+        return error;
+    }
+
+    bool hasUnsyncedRecords() const
+    {
+        return syncedLength < length;
+    }
+
+    bool open(const std::string &path)
+    {
+        close();
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        length = 0;
+        syncedLength = 0;
+        discarded = 0;
+        prefixDamaged = false;
+        readOnly = false;
+        return fd >= 0 || fail("cannot open log");
+    }
+
+    // Opens an existing log for reading only. Nothing is created, a torn tail
+    // is skipped rather than truncated, and append() refuses to write.
+    bool openReadOnly(const std::string &path)
+    {
+        close();
+        fd = ::open(path.c_str(), O_RDONLY);
+        length = 0;
+        syncedLength = 0;
+        discarded = 0;
+        prefixDamaged = false;
+        readOnly = true;
+        return fd >= 0 || fail("cannot open log");
+    }
+
+    void close()
+    {
+        if (fd >= 0)
+        {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+
+    // Walks the log and hands fn(type, key, offset) the leading key string of
+    // every intact record, without materialising payloads. Records inside
+    // trustedPrefix were fsynced before HEAD was last published, so only their
+    // framing is read; later records are checksummed in full. Anything after
+    // the first bad frame is truncated away so appends never follow garbage;
+    // a read-only log just ignores it. A bad frame (or the end of the file)
+    // inside trustedPrefix means durable history is damaged: nothing is cut
+    // and damagedBeforeTrustedPrefix() reports it. Returns the number of
+    // records found.
+    template <typename Fn>
+    size_t scan(uint64_t trustedPrefix, Fn fn)
+    {
+        struct stat st;
+        if (::fstat(fd, &st) != 0)
+        {
+            return 0;
+        }
+        uint64_t fileSize = (uint64_t)st.st_size;
+        ReadWindow window(fd);
+
+        uint64_t pos = 0;
+        size_t records = 0;
+        std::string header;
+        std::string key;
+        while (fileSize - pos >= FRAME_HEADER + 4)
+        {
+            if (!window.read(pos, FRAME_HEADER + 4, header))
+            {
+                break;
+            }
+            char type = header[8];
+            header.erase(8, 1);
+            ByteReader reader(header);
+            uint32_t payloadLength = reader.readU32();
+            uint32_t checksum = reader.readU32();
+            uint32_t keyLength = reader.readU32(); // peeks into the payload
+            uint64_t frameLength = FRAME_HEADER + (uint64_t)payloadLength;
+            if (fileSize - pos < frameLength || payloadLength < 4 || keyLength > payloadLength - 4)
+            {
+                break; // torn write
+            }
+            if (pos + frameLength > trustedPrefix)
+            {
+                std::string body;
+                if (!window.read(pos + 8, payloadLength + 1, body) || crc32(body.data(), body.size()) != checksum)
+                {
+                    break; // corrupted record
+                }
+            }
+            if (!window.read(pos + FRAME_HEADER + 4, keyLength, key))
+            {
+                break;
+            }
+            fn(type, key, pos);
+            pos += frameLength;
+            records++;
+        }
+
+        discarded = fileSize - pos;
+        prefixDamaged = pos < trustedPrefix;
+        if (prefixDamaged)
+        {
+            error = "log is damaged at offset " + std::to_string(pos) + ", inside the " +
+                    std::to_string(trustedPrefix) + " bytes HEAD records as durable";
+            discarded = 0;
+        }
+        else if (discarded > 0 && !readOnly && (::ftruncate(fd, (off_t)pos) != 0 || ::fsync(fd) != 0))
+        {
+            fail("cannot truncate log tail");
+        }
+        length = pos;
+        syncedLength = pos;
+        return records;
+    }
+
+    // Fetches the payload of the record at offset, re-verifying its checksum.
+    bool read(uint64_t offset, char expectedType, std::string &payload) const
+    {
+        char header[FRAME_HEADER];
+        if (::pread(fd, header, FRAME_HEADER, (off_t)offset) != (ssize_t)FRAME_HEADER)
+        {
+            return false;
+        }
+        std::string headerBytes(header, 8);
+        ByteReader reader(headerBytes);
+        uint32_t payloadLength = reader.readU32();
+        uint32_t checksum = reader.readU32();
+        if (header[8] != expectedType)
+        {
+            return false;
+        }
+
+        std::string body(payloadLength + 1, '\0');
+        body[0] = header[8];
+        size_t done = 0;
+        while (done < payloadLength)
+        {
+            ssize_t n = ::pread(fd, &body[1 + done], payloadLength - done, (off_t)(offset + FRAME_HEADER + done));
+            if (n <= 0)
+            {
+                if (n < 0 && errno == EINTR)
+                    continue;
+                return false;
+            }
+            done += (size_t)n;
+        }
+        if (crc32(body.data(), body.size()) != checksum)
+        {
+            return false;
+        }
+        payload.assign(body, 1, payloadLength);
+        return true;
+    }
+
+    // Writes the record to the OS; it only becomes durable after sync().
+    bool append(char type, const std::string &payload, uint64_t *offset = nullptr)
+    {
+        if (readOnly)
+        {
+            error = "log is open read-only";
+            return false;
+        }
+        std::string frame;
+        frame.reserve(FRAME_HEADER + payload.size());
+        std::string body;
+        body.reserve(payload.size() + 1);
+        body.push_back(type);
+        body += payload;
+        appendU32(frame, (uint32_t)payload.size());
+        appendU32(frame, crc32(body.data(), body.size()));
+        frame += body;
+
+        size_t written = 0;
+        while (written < frame.size())
+        {
+            ssize_t n = ::pwrite(fd, frame.data() + written, frame.size() - written, (off_t)(length + written));
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                return fail("log write failed");
+            }
+            written += (size_t)n;
+        }
+        if (offset)
+        {
+            *offset = length;
+        }
+        length += frame.size();
+        return true;
+    }
+
+    bool sync()
+    {
+        if (!hasUnsyncedRecords())
+        {
+            return true;
+        }
+        if (::fdatasync(fd) != 0)
+        {
+            return fail("log fsync failed");
+        }
+        syncedLength = length;
+        return true;
+    }
+};
+
+// Replaces path with content atomically: write a temp file, fsync it, then
+// rename over the target and fsync the directory so the rename itself sticks.
+bool writeFileAtomically(const std::string &dir, const std::string &name, const std::string &content)
+{
+    std::string target = dir + "/" + name;
+    std::string temp = target + ".tmp";
+    int fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        return false;
+    }
+    bool ok = ::write(fd, content.data(), content.size()) == (ssize_t)content.size() && ::fsync(fd) == 0;
+    ::close(fd);
+    if (!ok || ::rename(temp.c_str(), target.c_str()) != 0)
+    {
+        return false;
+    }
+    int dirFd = ::open(dir.c_str(), O_RDONLY);
+    if (dirFd >= 0)
+    {
+        ::fsync(dirFd);
+        ::close(dirFd);
+    }
+    return true;
+}
+
+bool readWholeFile(const std::string &path, std::string &content)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    content.clear();
+    char buffer[4096];
+    ssize_t n;
+    while ((n = ::read(fd, buffer, sizeof(buffer))) > 0)
+    {
+        content.append(buffer, (size_t)n);
+    }
+    ::close(fd);
+    return n == 0;
+}
+
+// Bounded cache with least-recently-used eviction. Pointers
+// returned by find/insert stay valid until the entry is evicted, i.e. until a
+// later insert pushes the cache past its capacity.
+template <typename K, typename V>
+class LruCache
+{
+private:
+    struct Entry
+    {
+        K key;
+        V value;
+        Entry *prev;
+        Entry *next;
+
+        Entry(const K &k, const V &v) : key(k), value(v), prev(nullptr), next(nullptr) {}
+    };
+
+    SimpleMap<K, Entry *> entries;
+    Entry *newest;
+    Entry *oldest;
+    size_t capacity;
+
+    void unlink(Entry *entry)
+    {
+        if (entry->prev)
+            entry->prev->next = entry->next;
+        else
+            newest = entry->next;
+        if (entry->next)
+            entry->next->prev = entry->prev;
+        else
+            oldest = entry->prev;
+        entry->prev = entry->next = nullptr;
+    }
+
+    void pushFront(Entry *entry)
+    {
+        entry->next = newest;
+        if (newest)
+            newest->prev = entry;
+        newest = entry;
+        if (!oldest)
+            oldest = entry;
+    }
+
+    void evictToCapacity()
+    {
+        while (entries.size() > capacity && oldest)
+        {
+            Entry *victim = oldest;
+            unlink(victim);
+            entries.remove(victim->key);
+            delete victim;
+        }
+    }
+
+public:
+    LruCache(size_t cap) : newest(nullptr), oldest(nullptr), capacity(cap == 0 ? 1 : cap) {}
+
+    LruCache(const LruCache &) = delete;
+    LruCache &operator=(const LruCache &) = delete;
+
+    ~LruCache()
+    {
+        clear();
+    }
+
+    V *find(const K &key)
+    {
+        Entry **entry = entries.find(key);
+        if (!entry)
+        {
+            return nullptr;
+        }
+        unlink(*entry);
+        pushFront(*entry);
+        return &(*entry)->value;
+    }
+
+    V *insert(const K &key, const V &value)
+    {
+        Entry **existing = entries.find(key);
+        if (existing)
+        {
+            (*existing)->value = value;
+            unlink(*existing);
+            pushFront(*existing);
+            return &(*existing)->value;
+        }
+        Entry *entry = new Entry(key, value);
+        entries.insert(key, entry);
+        pushFront(entry);
+        evictToCapacity();
+        return &entry->value;
+    }
+
+    void setCapacity(size_t cap)
+    {
+        capacity = cap == 0 ? 1 : cap;
+        evictToCapacity();
+    }
+
+    void clear()
+    {
+        while (oldest)
+        {
+            Entry *victim = oldest;
+            unlink(victim);
+            delete victim;
+        }
+        entries.clear();
+    }
+
+    size_t size() const
+    {
+        return entries.size();
+    }
+};
+
+struct CommitCodec
+{
+    static const char RECORD_TYPE = WriteAheadLog::RECORD_COMMIT;
+
+    static std::string encode(const std::string &, const Commit &commit)
+    {
+        return serializeCommit(commit);
+    }
+
+    static bool decode(const std::string &payload, Commit &commit)
+    {
+        return deserializeCommit(payload, commit);
+    }
+};
+
+struct BlobCodec
+{
+    static const char RECORD_TYPE = WriteAheadLog::RECORD_OBJECT;
+
+    static std::string encode(const std::string &contentHash, const std::string &content)
+    {
+        std::string payload;
+        appendString(payload, contentHash);
+        appendString(payload, content);
+        return payload;
+    }
+
+    static bool decode(const std::string &payload, std::string &content)
+    {
+        ByteReader reader(payload);
+        reader.readString();
+        content = reader.readString();
+        return reader.ok;
+    }
+};
+
+struct GraphCodec
+{
+    static const char RECORD_TYPE = WriteAheadLog::RECORD_GRAPH;
+
+    static std::string encode(const std::string &commitId, const CommitGraphEntry &entry)
+    {
+        std::string payload;
+        appendString(payload, commitId);
+        appendString(payload, entry.parentHex());
+        appendU64(payload, (uint64_t)entry.timestamp);
+        entry.changedPaths.serialize(payload);
+        return payload;
+    }
+
+    static bool decode(const std::string &payload, CommitGraphEntry &entry)
+    {
+        ByteReader reader(payload);
+        reader.readString();
+        bool validParent = entry.setParent(reader.readString());
+        entry.timestamp = (long)reader.readU64();
+        return entry.changedPaths.deserialize(reader) && validParent;
+    }
+};
+
+// Object ID -> value store that is fully resident until attached to a log.
+// Once attached it only keeps record offsets in memory; values are faulted in
+// from the log on first access and held in a bounded LRU cache, so memory use
+// is independent of history depth. Keys are binary ObjectIds; the hex
+// overloads parse first, and a key that is not a canonical ID is never stored.
+template <typename V, typename Codec>
+class LazyStore
+{
+private:
+    SimpleMap<ObjectId, V> resident;       // used while no log is attached
+    SimpleMap<ObjectId, uint64_t> offsets; // key -> log record offset
+    LruCache<ObjectId, V> cache;
+    WriteAheadLog *log;
+    size_t faults;
+
+    static SimpleVec<std::string> toHexKeys(const SimpleVec<ObjectId> &ids)
+    {
+        SimpleVec<std::string> keys;
+        for (size_t i = 0; i < ids.size(); ++i)
+        {
+            keys.push_back(ids[i].toHex());
+        }
+        return keys;
+    }
+
+public:
+    LazyStore(size_t cacheCapacity) : cache(cacheCapacity), log(nullptr), faults(0) {}
+
+    void attach(WriteAheadLog *wal)
+    {
+        clear();
+        log = wal;
+    }
+
+    // Registers a record found while scanning the attached log.
+    void index(const std::string &key, uint64_t offset)
+    {
+        ObjectId id;
+        if (ObjectId::fromHex(key, id))
+        {
+            offsets.insert(id, offset);
+        }
+    }
+
+    void setCacheCapacity(size_t capacity)
+    {
+        cache.setCapacity(capacity);
+    }
+
+    V *find(const std::string &key)
+    {
+        ObjectId id;
+        return ObjectId::fromHex(key, id) ? find(id) : nullptr;
+    }
+
+    V *find(const ObjectId &id)
+    {
+        if (!log)
+        {
+            return resident.find(id);
+        }
+        V *cached = cache.find(id);
+        if (cached)
+        {
+            return cached;
+        }
+        const uint64_t *offset = offsets.find(id);
+        if (!offset)
+        {
+            return nullptr;
+        }
+        std::string payload;
+        V value;
+        if (!log->read(*offset, Codec::RECORD_TYPE, payload) || !Codec::decode(payload, value))
+        {
+            return nullptr; // unreadable record: callers report the object as missing
+        }
+        faults++;
+        return cache.insert(id, value);
+    }
+
+    bool contains(const std::string &key) const
+    {
+        ObjectId id;
+        return ObjectId::fromHex(key, id) && contains(id);
+    }
+
+    bool contains(const ObjectId &id) const
+    {
+        return log ? offsets.contains(id) : resident.contains(id);
+    }
+
+    // Stores the value; when attached, it is appended to the log first.
+    bool insert(const std::string &key, const V &value)
+    {
+        ObjectId id;
+        return ObjectId::fromHex(key, id) && insert(id, value);
+    }
+
+    bool insert(const ObjectId &id, const V &value)
+    {
+        if (!log)
+        {
+            resident.insert(id, value);
+            return true;
+        }
+        uint64_t offset;
+        if (!log->append(Codec::RECORD_TYPE, Codec::encode(id.toHex(), value), &offset))
+        {
+            return false;
+        }
+        offsets.insert(id, offset);
+        cache.insert(id, value);
+        return true;
+    }
+
+    SimpleVec<std::string> getKeys() const
+    {
+        return toHexKeys(getIds());
+    }
+
+    SimpleVec<ObjectId> getIds() const
+    {
+        return log ? offsets.getKeys() : resident.getKeys();
+    }
+
+    size_t size() const
+    {
+        return log ? offsets.size() : resident.size();
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    size_t loadedCount() const
+    {
+        return log ? cache.size() : resident.size();
+    }
+
+    size_t faultCount() const
+    {
+        return faults;
+    }
+
+    void clear()
+    {
+        resident.clear();
+        offsets.clear();
+        cache.clear();
+        faults = 0;
+    }
+};
+
+// Fixed-size pool of worker threads draining a FIFO of jobs.
+class ThreadPool
+{
+private:
+    struct Job
+    {
+        std::function<void()> fn;
+        Job *next;
+        Job(std::function<void()> f) : fn(std::move(f)), next(nullptr) {}
+    };
+
+    SimpleVec<std::thread *> workers;
+    Job *head;
+    Job *tail;
+    std::mutex mutex;
+    std::condition_variable ready;
+    bool stopping;
+
+    void run()
+    {
+        while (true)
+        {
+            Job *job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                ready.wait(lock, [this] { return stopping || head != nullptr; });
+                if (!head)
+                {
+                    return; // stopping and drained
+                }
+                job = head;
+                head = head->next;
+                if (!head)
+                    tail = nullptr;
+            }
+            job->fn();
+            delete job;
+        }
+    }
+
+public:
+    ThreadPool(size_t threadCount) : head(nullptr), tail(nullptr), stopping(false)
+    {
+        if (threadCount == 0)
+        {
+            threadCount = 1;
+        }
+        for (size_t i = 0; i < threadCount; ++i)
+        {
+            workers.push_back(new std::thread([this] { run(); }));
+        }
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Finishes every queued job before joining.
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        ready.notify_all();
+        for (size_t i = 0; i < workers.size(); ++i)
+        {
+            workers[i]->join();
+            delete workers[i];
+        }
+    }
+
+    void submit(std::function<void()> fn)
+    {
+        Job *job = new Job(std::move(fn));
+        // Notify under the lock: the job may finish (and its owner tear the
+        // pool down) before an unlocked notify would run.
+        std::lock_guard<std::mutex> lock(mutex);
+        if (tail)
+            tail->next = job;
+        else
+            head = job;
+        tail = job;
+        ready.notify_one();
+    }
+};
+
+// Bounded FIFO handing items between pipeline threads. close() wakes every
+// waiter: pop() then drains what is left and returns false, push() fails.
+template <typename T>
+class BoundedQueue
+{
+private:
+    T *slots;
+    size_t capacity;
+    size_t head;
+    size_t count;
+    bool closed;
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+
+public:
+    BoundedQueue(size_t cap) : slots(new T[cap == 0 ? 1 : cap]), capacity(cap == 0 ? 1 : cap), head(0), count(0), closed(false) {}
+
+    BoundedQueue(const BoundedQueue &) = delete;
+    BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+    ~BoundedQueue()
+    {
+        delete[] slots;
+    }
+
+    bool push(const T &value)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this] { return closed || count < capacity; });
+        if (closed)
+        {
+            return false;
+        }
+        slots[(head + count) % capacity] = value;
+        count++;
+        notEmpty.notify_one();
+        return true;
+    }
+
+    bool pop(T &value)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this] { return closed || count > 0; });
+        if (count == 0)
+        {
+            return false;
+        }
+        value = slots[head];
+        head = (head + 1) % capacity;
+        count--;
+        notFull.notify_one();
+        return true;
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        notEmpty.notify_all();
+        notFull.notify_all();
+    }
+};
+
+// --- Delta encoding ---
+// A delta is [u32 target length] followed by ops: 'C' u32 offset u32 length
+// (copy from base) or 'I' string (insert literal bytes).
+
+std::string encodeDelta(const std::string &base, const std::string &target)
+{
+    static const size_t BLOCK = 16;
+    static const size_t MAX_SHIFT = 8;       // resync window around the previous copy
+    static const size_t MAX_CANDIDATES = 32; // occurrences of one block to consider
+    std::string delta;
+    appendU32(delta, (uint32_t)target.size());
+
+    // Most revisions change a small region, so the common prefix is copied
+    // outright and only the rest of the base is indexed.
+    size_t prefix = 0;
+    while (prefix < base.size() && prefix < target.size() && base[prefix] == target[prefix])
+    {
+        prefix++;
+    }
+    if (prefix >= BLOCK)
+    {
+        delta.push_back('C');
+        appendU32(delta, 0);
+        appendU32(delta, (uint32_t)prefix);
+    }
+    else
+    {
+        prefix = 0;
+    }
+
+    // Index every aligned block of the rest of the base; matches are then
+    // extended in both directions, so unaligned edits still copy most of
+    // it. Repeated blocks are chained so a lookup can pick the occurrence
+    // nearest the previous copy rather than the first one.
+    SimpleMap<std::string, size_t> blocks; // block -> last occurrence
+    SimpleVec<size_t> previousSame;        // per block: earlier occurrence + 1, or 0
+    for (size_t i = prefix; i + BLOCK <= base.size(); i += BLOCK)
+    {
+        std::string block = base.substr(i, BLOCK);
+        size_t *last = blocks.find(block);
+        previousSame.push_back(last ? *last + 1 : 0); // indexed by (i - prefix) / BLOCK
+        if (last)
+        {
+            *last = i;
+        }
+        else
+        {
+            blocks.insert(block, i);
+        }
+    }
+
+    size_t literalStart = prefix;
+    size_t pos = prefix;
+    size_t baseCursor = prefix; // where the previous copy ended in base
+    while (!blocks.empty() && pos + BLOCK <= target.size())
+    {
+        // A small edit shifts what follows by a few bytes, so first look for
+        // the continuation right around where the previous copy ended; this
+        // keeps repetitive text from latching onto a distant lookalike.
+        size_t expected = baseCursor + (pos - literalStart);
+        size_t from = SIZE_MAX;
+        size_t lowest = expected > MAX_SHIFT ? expected - MAX_SHIFT : 0;
+        for (size_t candidate = lowest; candidate <= expected + MAX_SHIFT && candidate + BLOCK <= base.size(); ++candidate)
+        {
+            if (target.compare(pos, BLOCK, base, candidate, BLOCK) == 0)
+            {
+                from = candidate;
+                break;
+            }
+        }
+        if (from == SIZE_MAX)
+        {
+            const size_t *last = blocks.find(target.substr(pos, BLOCK));
+            if (!last)
+            {
+                pos++;
+                continue;
+            }
+            from = *last;
+            size_t candidate = *last;
+            for (size_t tries = 0; tries < MAX_CANDIDATES && previousSame[(candidate - prefix) / BLOCK] != 0; ++tries)
+            {
+                candidate = previousSame[(candidate - prefix) / BLOCK] - 1;
+                size_t distance = candidate > expected ? candidate - expected : expected - candidate;
+                size_t best = from > expected ? from - expected : expected - from;
+                if (distance < best)
+                {
+                    from = candidate;
+                }
+            }
+        }
+        size_t length = BLOCK;
+        while (pos + length < target.size() && from + length < base.size() && target[pos + length] == base[from + length])
+        {
+            length++;
+        }
+        while (pos > literalStart && from > prefix && target[pos - 1] == base[from - 1])
+        {
+            pos--;
+            from--;
+            length++;
+        }
+        if (pos > literalStart)
+        {
+            delta.push_back('I');
+            appendString(delta, target.substr(literalStart, pos - literalStart));
+        }
+        delta.push_back('C');
+        appendU32(delta, (uint32_t)from);
+        appendU32(delta, (uint32_t)length);
+        pos += length;
+        literalStart = pos;
+        baseCursor = from + length;
+    }
+    if (literalStart < target.size())
+    {
+        delta.push_back('I');
+        appendString(delta, target.substr(literalStart));
+    }
+    return delta;
+}
+
+bool applyDelta(const std::string &base, const std::string &delta, std::string &target)
+{
+    ByteReader reader(delta);
+    uint32_t targetLength = reader.readU32();
+    target.clear();
+    target.reserve(targetLength);
+    while (reader.ok && reader.pos < delta.size())
+    {
+        unsigned char op = reader.readU8();
+        if (op == 'C')
+        {
+            uint32_t from = reader.readU32();
+            uint32_t length = reader.readU32();
+            if (!reader.ok || from > base.size() || length > base.size() - from)
+            {
+                return false;
+            }
+            target.append(base, from, length);
+        }
+        else if (op == 'I')
+        {
+            target += reader.readString();
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return reader.ok && target.size() == targetLength;
+}
+
+// --- Line diff ---
+
+SimpleVec<std::string> splitLines(const std::string &content)
+{
+    SimpleVec<std::string> lines;
+    size_t start = 0;
+    while (start < content.size())
+    {
+        size_t end = content.find('\n', start);
+        if (end == std::string::npos)
+        {
+            end = content.size();
+        }
+        lines.push_back(content.substr(start, end - start));
+        start = end + 1;
+    }
+    return lines;
+}
+
+// Longest-common-subsequence line matching. Returns, for every line of
+// newLines, the index of the line it was carried over from in oldLines, or -1
+// if it was added. Common prefix/suffix are matched directly; a middle section
+// too large for the quadratic table is treated as a full rewrite.
+SimpleVec<long> matchLines(const SimpleVec<std::string> &oldLines, const SimpleVec<std::string> &newLines)
+{
+    static const size_t MAX_TABLE_CELLS = 4000000;
+    size_t oldCount = oldLines.size();
+    size_t newCount = newLines.size();
+
+    SimpleVec<long> match;
+    for (size_t i = 0; i < newCount; ++i)
+    {
+        match.push_back(-1);
+    }
+
+    size_t prefix = 0;
+    while (prefix < oldCount && prefix < newCount && oldLines[prefix] == newLines[prefix])
+    {
+        match[prefix] = (long)prefix;
+        prefix++;
+    }
+    size_t suffix = 0;
+    while (suffix < oldCount - prefix && suffix < newCount - prefix &&
+           oldLines[oldCount - 1 - suffix] == newLines[newCount - 1 - suffix])
+    {
+        match[newCount - 1 - suffix] = (long)(oldCount - 1 - suffix);
+        suffix++;
+    }
+
+    size_t n = oldCount - prefix - suffix;
+    size_t m = newCount - prefix - suffix;
+    if (n == 0 || m == 0 || (n + 1) * (m + 1) > MAX_TABLE_CELLS)
+    {
+        return match;
+    }
+
+    // table[i][j] = LCS length of old[prefix+i..] and new[prefix+j..]
+    unsigned int *table = new unsigned int[(n + 1) * (m + 1)];
+    for (size_t i = n + 1; i-- > 0;)
+    {
+        for (size_t j = m + 1; j-- > 0;)
+        {
+            unsigned int &cell = table[i * (m + 1) + j];
+            if (i == n || j == m)
+                cell = 0;
+            else if (oldLines[prefix + i] == newLines[prefix + j])
+                cell = table[(i + 1) * (m + 1) + j + 1] + 1;
+            else
+            {
+                unsigned int down = table[(i + 1) * (m + 1) + j];
+                unsigned int right = table[i * (m + 1) + j + 1];
+                cell = down > right ? down : right;
+            }
+        }
+    }
+    size_t i = 0;
+    size_t j = 0;
+    while (i < n && j < m)
+    {
+        if (oldLines[prefix + i] == newLines[prefix + j])
+        {
+            match[prefix + j] = (long)(prefix + i);
+            i++;
+            j++;
+        }
+        else if (table[(i + 1) * (m + 1) + j] >= table[i * (m + 1) + j + 1])
+            i++;
+        else
+            j++;
+    }
+    delete[] table;
+    return match;
+}
+
+// Filters for log(). Timestamps are inclusive seconds since the epoch.
+struct LogOptions
+{
+    static const size_t NO_LIMIT = SIZE_MAX;
+
+    size_t maxCount; // NO_LIMIT by default; 0 shows nothing, as in git
+    std::string path; // file or directory; empty = whole tree
+    long since;
+    long until;
+
+    LogOptions() : maxCount(NO_LIMIT), since(LONG_MIN), until(LONG_MAX) {}
+
+    bool hasTimeRange() const
+    {
+        return since != LONG_MIN || until != LONG_MAX;
+    }
+
+    // Accepts "1718000000", "2024-06-10" or "2024-06-10 14:30:00" (local time).
+    static bool parseTime(const std::string &text, long &out)
+    {
+        if (!text.empty() && text.find_first_not_of("0123456789") == std::string::npos)
+        {
+            errno = 0;
+            long value = std::strtol(text.c_str(), nullptr, 10);
+            if (errno == ERANGE)
+            {
+                return false;
+            }
+            out = value;
+            return true;
+        }
+        std::tm tm = {};
+        int fields = std::sscanf(text.c_str(), "%d-%d-%d %d:%d:%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
+                                 &tm.tm_hour, &tm.tm_min, &tm.tm_sec);
+        if (fields != 3 && fields != 6)
+        {
+            return false;
+        }
+        tm.tm_year -= 1900;
+        tm.tm_mon -= 1;
+        tm.tm_isdst = -1;
+        std::time_t t = std::mktime(&tm);
+        if (t == (std::time_t)-1)
+        {
+            return false;
+        }
+        out = (long)t;
+        return true;
+    }
+
+    // Parses git-style arguments: --max-count=N, --since=T, --until=T, -- <path>
+    static bool parse(const SimpleVec<std::string> &args, LogOptions &options, std::string &error)
+    {
+        options = LogOptions();
+        for (size_t i = 0; i < args.size(); ++i)
+        {
+            const std::string &arg = args[i];
+            if (arg == "--")
+            {
+                if (i + 1 != args.size() - 1)
+                {
+                    error = "expected exactly one path after '--'";
+                    return false;
+                }
+                options.path = args[i + 1];
+                while (options.path.size() > 1 && options.path[options.path.size() - 1] == '/')
+                {
+                    options.path.erase(options.path.size() - 1);
+                }
+                return true;
+            }
+            else if (arg.rfind("--max-count=", 0) == 0)
+            {
+                std::string value = arg.substr(12);
+                if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos)
+                {
+                    error = "invalid --max-count '" + value + "'";
+                    return false;
+                }
+                errno = 0;
+                unsigned long long count = std::strtoull(value.c_str(), nullptr, 10);
+                if (errno == ERANGE || count >= NO_LIMIT)
+                {
+                    error = "--max-count '" + value + "' is out of range";
+                    return false;
+                }
+                options.maxCount = (size_t)count;
+            }
+            else if (arg.rfind("--since=", 0) == 0)
+            {
+                if (!parseTime(arg.substr(8), options.since))
+                {
+                    error = "invalid --since '" + arg.substr(8) + "'";
+                    return false;
+                }
+            }
+            else if (arg.rfind("--until=", 0) == 0)
+            {
+                if (!parseTime(arg.substr(8), options.until))
+                {
+                    error = "invalid --until '" + arg.substr(8) + "'";
+                    return false;
+                }
+            }
+            else
+            {
+                error = "unknown log option '" + arg + "'";
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+struct TimeIndexEntry
+{
+    long timestamp;
+    ObjectId commitId;
+    TimeIndexEntry() : timestamp(0) {}
+};
+
+// --- Structured results ---
+
+enum class Status
+{
+    Ok,
+    NotInitialized,
+    AlreadyInitialized,
+    NothingToCommit,
+    NotFound,
+    Ambiguous,
+    StorageError
+};
+
+struct OpenResult
+{
+    Status status;
+    std::string error;         // set when status is StorageError
+    bool recovered;            // existing history was found
+    size_t records;            // log records indexed
+    size_t commitCount;
+    uint64_t discardedBytes;   // torn log tail dropped during recovery
+    bool logShorterThanHead;   // the log lost data HEAD says was durable
+    std::string headCommitId;
+    OpenResult() : status(Status::Ok), recovered(false), records(0), commitCount(0), discardedBytes(0), logShorterThanHead(false) {}
+};
+
+struct InitResult
+{
+    Status status;
+    std::string commitId;
+    InitResult() : status(Status::Ok) {}
+};
+
+struct AddResult
+{
+    Status status;
+    std::string contentHash;
+    bool staged; // false when the content matches HEAD or is already staged
+    AddResult() : status(Status::Ok), staged(false) {}
+};
+
+struct CommitResult
+{
+    Status status;
+    std::string commitId;
+    CommitResult() : status(Status::Ok) {}
+};
+
+struct FileEntry
+{
+    std::string filename;
+    std::string contentHash;
+};
+
+struct LogEntry
+{
+    std::string id;
+    std::string parentId;
+    std::string message;
+    long timestamp;
+    SimpleVec<FileEntry> files; // sorted by filename, limited to the log path filter
+    LogEntry() : timestamp(0) {}
+};
+
+struct CheckoutResult
+{
+    Status status;
+    std::string commitId;
+    bool resolvedFromPrefix;
+    bool stagingCleared;
+    CheckoutResult() : status(Status::Ok), resolvedFromPrefix(false), stagingCleared(false) {}
+};
+
+struct TrackedFile
+{
+    std::string filename;
+    std::string contentHash;
+    std::string content;
+    bool contentAvailable; // false when the blob is missing from the store
+    bool outsideSparse;    // partial clone: excluded by the sparse filter, not fetched
+    TrackedFile() : contentAvailable(false), outsideSparse(false) {}
+};
+
+// Snapshot of HEAD's files and the staging area.
+struct FileState
+{
+    Status status;
+    std::string headCommitId;
+    SimpleVec<TrackedFile> tracked; // sorted by filename
+    SimpleVec<FileEntry> staged;    // sorted by filename
+    FileState() : status(Status::Ok) {}
+};
+
+struct BlameLine
+{
+    std::string commitId;
+    long timestamp;
+    size_t lineNumber; // 1-based, in the blamed (HEAD) version
+    std::string text;
+    BlameLine() : timestamp(0), lineNumber(0) {}
+};
+
+struct BlameResult
+{
+    Status status;
+    SimpleVec<BlameLine> lines;
+    BlameResult() : status(Status::Ok) {}
+};
+
+// Which history a bundle carries: everything reachable from tip (HEAD when
+// empty) that is not reachable from a commit the receiver already has.
+struct BundleRange
+{
+    std::string tip;
+    SimpleVec<std::string> haves; // from the receiver's advertiseHaves()
+};
+
+struct BundleResult
+{
+    Status status;
+    std::string error;
+    std::string tip;
+    std::string boundary;  // newest commit both sides have (export only)
+    size_t commits;        // commits written / newly imported
+    size_t blobs;          // blobs written / newly imported
+    size_t deltas;         // blobs sent or received as deltas
+    uint64_t bytes;        // bundle size
+    BundleResult() : status(Status::Ok), commits(0), blobs(0), deltas(0), bytes(0) {}
+};
+
+// How much of a source repository clone() copies. Anything left out is
+// fetched from the source on first use.
+struct CloneOptions
+{
+    size_t depth;                       // newest first-parent commits to copy, 0 = all
+    bool blobless;                      // copy no blobs up front
+    SimpleVec<std::string> sparsePaths; // files/directories to materialise, empty = all
+    CloneOptions() : depth(0), blobless(false) {}
+};
+
+struct CloneResult
+{
+    Status status;
+    std::string error;
+    std::string headCommitId;
+    size_t commits; // commits copied
+    size_t blobs;   // blobs copied up front
+    bool shallow;   // history was cut off at depth
+    CloneResult() : status(Status::Ok), commits(0), blobs(0), shallow(false) {}
+};
+
+class Gitlet
+{
+private:
+    bool initialized;
+    SimpleMap<std::string, ObjectId, PathHash> stagingArea; // filename -> contentHash
+    LazyStore<std::string, BlobCodec> objectStore; // contentHash -> content
+    LazyStore<Commit, CommitCodec> commits;         // commitId -> Commit object
+    LazyStore<CommitGraphEntry, GraphCodec> commitGraph; // commitId -> parent, time, changed paths
+    std::string headCommitId;
+    SimpleVec<TimeIndexEntry> timeIndex; // every commit, sorted by (timestamp, id); built on first use
+    bool timeIndexReady;
+
+    // --- Persistence (only active after open()) ---
+    std::string repoPath;
+    WriteAheadLog wal;
+    size_t groupCommitSize; // commits per fsync, 1 = sync every commit
+    size_t unsyncedCommits;
+    bool headDirty;         // HEAD file lags the log
+    bool readOnly;          // opened with openReadOnly(): never publish HEAD
+
+    // --- Partial clones (only active after clone()) ---
+    std::string backingPath;            // source repository missing blobs come from
+    Gitlet *backingStore;               // opened on first fetch
+    SimpleVec<std::string> sparsePaths; // empty = every path is materialised
+    size_t fetchedBlobs;
+    LruCache<ObjectId, std::string> unloggedBlobs; // fetched while read-only, so not stored
+
+    bool isPersistent() const
+    {
+        return wal.isOpen();
+    }
+
+    // Logs the HEAD move. Durability is deferred to the group commit policy;
+    // false means the move could not be logged or a due sync failed.
+    bool persistHead()
+    {
+        if (!isPersistent())
+        {
+            return true;
+        }
+        std::string payload;
+        appendString(payload, headCommitId);
+        if (!wal.append(WriteAheadLog::RECORD_HEAD, payload))
+        {
+            return false;
+        }
+        headDirty = true;
+        if (unsyncedCommits >= groupCommitSize || unsyncedCommits == 0)
+        {
+            return sync();
+        }
+        return true;
+    }
+
+    std::string generateCommitId(const Commit &commit)
+    {
+        std::stringstream dataStream;
+        dataStream << commit.message << commit.timestamp << commit.parentId;
+
+        // Get keys, sort them, then access values for hashing
+        SimpleVec<std::string> sortedFilenames = commit.trackedFiles.getKeys();
+        bubbleSort(sortedFilenames); // Use our simple sort
+
+        for (size_t i = 0; i < sortedFilenames.size(); ++i)
+        {
+            const std::string &fname = sortedFilenames[i];
+            const ObjectId *contentHashPtr = commit.trackedFiles.find(fname); // find returns pointer
+            if (contentHashPtr)
+            { // Should always be found if key came from getKeys
+                dataStream << fname << contentHashPtr->toHex();
+            }
+        }
+
+        return hashToString(simpleHash(dataStream.str()));
+    }
+
+    // A partial clone's backing store, opened read-only on first use; null
+    // for a full repository or when the source cannot be opened.
+    Gitlet *openBackingStore()
+    {
+        if (!backingStore && !backingPath.empty())
+        {
+            backingStore = new Gitlet();
+            if (backingStore->openReadOnly(backingPath).status != Status::Ok)
+            {
+                delete backingStore;
+                backingStore = nullptr;
+            }
+        }
+        return backingStore;
+    }
+
+    // Whether findBlob() can produce the blob, without fetching it.
+    bool hasBlob(const ObjectId &contentHash)
+    {
+        if (objectStore.contains(contentHash))
+        {
+            return true;
+        }
+        Gitlet *backing = openBackingStore();
+        return backing && backing->hasBlob(contentHash);
+    }
+
+    // Blob content; a partial clone fetches blobs it lacks from its backing
+    // store (which may itself be partial) and keeps them: they are logged
+    // like any other blob, or only cached when the repository is read-only.
+    const std::string *findBlob(const ObjectId &contentHash)
+    {
+        const std::string *content = objectStore.find(contentHash);
+        if (content || !openBackingStore())
+        {
+            return content;
+        }
+        content = unloggedBlobs.find(contentHash);
+        if (content)
+        {
+            return content;
+        }
+        const std::string *fetched = backingStore->findBlob(contentHash);
+        if (!fetched || hashContent(*fetched) != contentHash.toHex())
+        {
+            return nullptr;
+        }
+        std::string copy = *fetched;
+        fetchedBlobs++;
+        if (readOnly)
+        {
+            return unloggedBlobs.insert(contentHash, copy);
+        }
+        if (!objectStore.insert(contentHash, copy))
+        {
+            return nullptr;
+        }
+        return objectStore.find(contentHash);
+    }
+
+    const std::string *findBlob(const std::string &contentHash)
+    {
+        ObjectId id;
+        return ObjectId::fromHex(contentHash, id) ? findBlob(id) : nullptr;
+    }
+
+    bool inSparseSet(const std::string &filename) const
+    {
+        if (sparsePaths.empty())
+        {
+            return true;
+        }
+        for (size_t i = 0; i < sparsePaths.size(); ++i)
+        {
+            if (isUnderPath(filename, sparsePaths[i]))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // The "partial" file records where missing blobs come from and the
+    // sparse filter, so a reopened clone keeps fetching on demand.
+    bool writePartialConfig()
+    {
+        if (!isPersistent() || backingPath.empty())
+        {
+            return true;
+        }
+        std::string config = "backing\t" + backingPath + "\n";
+        for (size_t i = 0; i < sparsePaths.size(); ++i)
+        {
+            config += "sparse\t" + sparsePaths[i] + "\n";
+        }
+        return writeFileAtomically(repoPath, "partial", config);
+    }
+
+    void readPartialConfig()
+    {
+        std::string config;
+        if (!readWholeFile(repoPath + "/partial", config))
+        {
+            return;
+        }
+        std::istringstream in(config);
+        std::string line;
+        while (std::getline(in, line))
+        {
+            size_t tab = line.find('\t');
+            if (tab == std::string::npos)
+            {
+                continue;
+            }
+            std::string key = line.substr(0, tab);
+            if (key == "backing")
+            {
+                backingPath = line.substr(tab + 1);
+            }
+            else if (key == "sparse")
+            {
+                sparsePaths.push_back(normalizeSparsePath(line.substr(tab + 1)));
+            }
+        }
+    }
+
+    // "src/" and "src" name the same directory, as in LogOptions::parse.
+    static std::string normalizeSparsePath(std::string path)
+    {
+        while (path.size() > 1 && path[path.size() - 1] == '/')
+        {
+            path.erase(path.size() - 1);
+        }
+        return path;
+    }
+
+    Commit *getHeadCommit()
+    {
+        if (headCommitId.empty())
+            return nullptr;
+        return commits.find(headCommitId); // find returns pointer, null if not found
+    }
+
+    Commit *getCommit(const std::string &commitId)
+    {
+        return commits.find(commitId); // find returns pointer, null if not found
+    }
+
+    Commit *getCommit(const ObjectId &commitId)
+    {
+        return commits.find(commitId);
+    }
+
+    // A shallow root keeps its parent ID in the commit but not in the graph,
+    // so history walks stop there.
+    void recordGraphEntry(const Commit &commit, const SimpleVec<std::string> &changedPaths, bool shallowRoot = false)
+    {
+        CommitGraphEntry entry;
+        entry.setParent(shallowRoot ? std::string() : commit.parentId);
+        entry.timestamp = commit.timestamp;
+        entry.changedPaths = BloomFilter::build(changedPaths);
+        commitGraph.insert(commit.id, entry);
+    }
+
+    // Graph node for a commit; falls back to the full commit (with an
+    // always-"maybe" filter) for history written before graph records existed.
+    bool getGraphEntry(const ObjectId &commitId, CommitGraphEntry &entry)
+    {
+        const CommitGraphEntry *cached = commitGraph.find(commitId);
+        if (cached)
+        {
+            entry = *cached;
+            return true;
+        }
+        const Commit *commit = getCommit(commitId);
+        if (!commit)
+        {
+            return false;
+        }
+        entry = CommitGraphEntry();
+        entry.setParent(commit->parentId);
+        entry.timestamp = commit->timestamp;
+        return true;
+    }
+
+    bool getGraphEntry(const std::string &commitId, CommitGraphEntry &entry)
+    {
+        ObjectId id;
+        return ObjectId::fromHex(commitId, id) && getGraphEntry(id, entry);
+    }
+
+    bool readFileAt(const ObjectId &commitId, const std::string &path, ObjectId &contentHash)
+    {
+        const Commit *commit = getCommit(commitId);
+        if (!commit)
+        {
+            return false;
+        }
+        const ObjectId *hashPtr = commit->trackedFiles.find(path);
+        if (!hashPtr)
+        {
+            return false;
+        }
+        contentHash = *hashPtr;
+        return true;
+    }
+
+    static bool timeIndexLess(const TimeIndexEntry &a, const TimeIndexEntry &b)
+    {
+        if (a.timestamp != b.timestamp)
+        {
+            return a.timestamp < b.timestamp;
+        }
+        return std::memcmp(a.commitId.bytes, b.commitId.bytes, sizeof(a.commitId.bytes)) < 0;
+    }
+
+    // Builds the timestamp-sorted index from graph records only; no commit
+    // manifests are loaded. Kept up to date by commit() afterwards.
+    void ensureTimeIndex()
+    {
+        if (timeIndexReady)
+        {
+            return;
+        }
+        timeIndex.clear();
+        SimpleVec<ObjectId> ids = commits.getIds();
+        for (size_t i = 0; i < ids.size(); ++i)
+        {
+            CommitGraphEntry node;
+            if (getGraphEntry(ids[i], node))
+            {
+                TimeIndexEntry entry;
+                entry.timestamp = node.timestamp;
+                entry.commitId = ids[i];
+                timeIndex.push_back(entry);
+            }
+        }
+        mergeSort(timeIndex, timeIndexLess);
+        timeIndexReady = true;
+    }
+
+    void addToTimeIndex(const Commit &commit)
+    {
+        if (!timeIndexReady)
+        {
+            return;
+        }
+        TimeIndexEntry entry;
+        entry.timestamp = commit.timestamp;
+        if (!ObjectId::fromHex(commit.id, entry.commitId))
+        {
+            return;
+        }
+        timeIndex.push_back(entry);
+        // Commits almost always arrive in time order, so this rarely shifts.
+        for (size_t i = timeIndex.size() - 1; i > 0 && timeIndexLess(timeIndex[i], timeIndex[i - 1]); --i)
+        {
+            TimeIndexEntry temp = timeIndex[i];
+            timeIndex[i] = timeIndex[i - 1];
+            timeIndex[i - 1] = temp;
+        }
+    }
+
+    // First index whose timestamp is >= t (or > t when strictlyAfter).
+    size_t timeIndexBound(long t, bool strictlyAfter) const
+    {
+        size_t lo = 0;
+        size_t hi = timeIndex.size();
+        while (lo < hi)
+        {
+            size_t mid = lo + (hi - lo) / 2;
+            bool before = strictlyAfter ? timeIndex[mid].timestamp <= t : timeIndex[mid].timestamp < t;
+            if (before)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return lo;
+    }
+
+    static bool isUnderPath(const std::string &filename, const std::string &path)
+    {
+        return filename == path ||
+               (filename.size() > path.size() && filename.compare(0, path.size(), path) == 0 && filename[path.size()] == '/');
+    }
+
+    static void collectUnderPath(const Manifest &files, const std::string &path,
+                                 SimpleMap<std::string, ObjectId, PathHash> &out)
+    {
+        SimpleVec<std::string> names = files.getKeys();
+        for (size_t i = 0; i < names.size(); ++i)
+        {
+            if (isUnderPath(names[i], path))
+            {
+                out.insert(names[i], *files.find(names[i]));
+            }
+        }
+    }
+
+    // Whether the commit changed path (a file or directory) relative to its
+    // parent. The Bloom filter answers most calls without touching manifests.
+    bool commitTouchesPath(const ObjectId &commitId, const CommitGraphEntry &node, const std::string &path)
+    {
+        if (!node.changedPaths.mightContain(path))
+        {
+            return false;
+        }
+        SimpleMap<std::string, ObjectId, PathHash> mine;
+        const Commit *commit = getCommit(commitId);
+        if (!commit)
+        {
+            return false;
+        }
+        collectUnderPath(commit->trackedFiles, path, mine);
+
+        const Commit *parent = node.hasParent ? getCommit(node.parentId) : nullptr;
+        if (!parent)
+        {
+            return !mine.empty();
+        }
+        SimpleMap<std::string, ObjectId, PathHash> theirs;
+        collectUnderPath(parent->trackedFiles, path, theirs);
+        if (mine.size() != theirs.size())
+        {
+            return true;
+        }
+        SimpleVec<std::string> names = mine.getKeys();
+        for (size_t i = 0; i < names.size(); ++i)
+        {
+            const ObjectId *parentHash = theirs.find(names[i]);
+            if (!parentHash || *parentHash != *mine.find(names[i]))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static LogEntry makeLogEntry(const Commit &commit, const std::string &pathFilter)
+    {
+        LogEntry entry;
+        entry.id = commit.id;
+        entry.parentId = commit.parentId;
+        entry.message = commit.message;
+        entry.timestamp = commit.timestamp;
+
+        SimpleVec<std::string> trackedKeys = commit.trackedFiles.getKeys();
+        bubbleSort(trackedKeys); // Sort for consistent output
+        for (size_t i = 0; i < trackedKeys.size(); ++i)
+        {
+            if (!pathFilter.empty() && !isUnderPath(trackedKeys[i], pathFilter))
+            {
+                continue;
+            }
+            FileEntry file;
+            file.filename = trackedKeys[i];
+            file.contentHash = commit.trackedFiles.find(trackedKeys[i])->toHex();
+            entry.files.push_back(file);
+        }
+        return entry;
+    }
+
+    static constexpr const char *BUNDLE_MAGIC = "GLTBNDL1";
+    static const uint32_t MAX_BUNDLE_RECORD = 1u << 30;
+    static const size_t BUNDLE_READ_CHUNK = 1u << 20;
+
+    static void writeBundleRecord(std::ostream &out, char type, const std::string &payload, uint32_t &crc, uint64_t &bytes)
+    {
+        std::string header(1, type);
+        appendU32(header, (uint32_t)payload.size());
+        out.write(header.data(), (std::streamsize)header.size());
+        out.write(payload.data(), (std::streamsize)payload.size());
+        crc = crc32Update(crc, header.data(), header.size());
+        crc = crc32Update(crc, payload.data(), payload.size());
+        bytes += header.size() + payload.size();
+    }
+
+    // Verifies and adds one bundled commit; the blobs it introduces are
+    // already stored. Its parent must be here too unless the bundle marked it
+    // as a shallow root, in which case it becomes one here as well. A partial
+    // clone may lack blobs its backing store can supply.
+    bool importCommit(const std::string &payload, const SimpleMap<std::string, bool> &shallowRoots,
+                      BundleResult &result)
+    {
+        Commit commit;
+        if (!deserializeCommit(payload, commit) || generateCommitId(commit) != commit.id)
+        {
+            result.error = "commit " + commit.id + " does not match its content";
+            return false;
+        }
+        if (commits.contains(commit.id))
+        {
+            return true;
+        }
+        bool shallowRoot = !commit.parentId.empty() && !commits.contains(commit.parentId);
+        if (shallowRoot && !shallowRoots.contains(commit.id))
+        {
+            result.error = "commit " + commit.id + " is missing its parent " + commit.parentId;
+            return false;
+        }
+
+        Manifest parentFiles;
+        if (!commit.parentId.empty() && !shallowRoot)
+        {
+            const Commit *parent = getCommit(commit.parentId);
+            if (!parent)
+            {
+                result.error = "cannot read parent " + commit.parentId + " of commit " + commit.id;
+                return false;
+            }
+            parentFiles = parent->trackedFiles;
+        }
+        SimpleVec<std::string> changedPaths;
+        SimpleVec<std::string> names = commit.trackedFiles.getKeys();
+        for (size_t i = 0; i < names.size(); ++i)
+        {
+            const ObjectId &contentHash = *commit.trackedFiles.find(names[i]);
+            if (!hasBlob(contentHash))
+            {
+                result.error = "commit " + commit.id + " references missing blob " + contentHash.toHex();
+                return false;
+            }
+            const ObjectId *parentHash = parentFiles.find(names[i]);
+            if (!parentHash || *parentHash != contentHash)
+            {
+                changedPaths.push_back(names[i]);
+            }
+        }
+
+        if (!commits.insert(commit.id, commit))
+        {
+            result.error = "cannot store commit " + commit.id;
+            return false;
+        }
+        recordGraphEntry(commit, changedPaths, shallowRoot);
+        addToTimeIndex(commit);
+        unsyncedCommits++;
+        result.commits++;
+        return true;
+    }
+
+    // Attributes every line of path at HEAD to the commit that introduced it.
+    // Walks first-parent history one "version" of the file at a time: commits
+    // whose changed-path filter rules the path out are skipped without loading
+    // their manifest, and at each real change the line diff against the parent
+    // decides which lines stop there and which are carried further back.
+    // Lines are stamped with their commit's ID and time as they are assigned.
+    bool computeBlame(const std::string &path, SimpleVec<BlameLine> &result)
+    {
+        ObjectId commitId;
+        ObjectId currentHash;
+        if (!ObjectId::fromHex(headCommitId, commitId) || !readFileAt(commitId, path, currentHash))
+        {
+            return false;
+        }
+        const std::string *content = findBlob(currentHash);
+        if (!content)
+        {
+            return false;
+        }
+        SimpleVec<std::string> currentLines = splitLines(*content);
+
+        result.clear();
+        SimpleVec<long> pending; // line in current version -> result index, or -1
+        for (size_t i = 0; i < currentLines.size(); ++i)
+        {
+            BlameLine line;
+            line.lineNumber = i + 1;
+            line.text = currentLines[i];
+            result.push_back(line);
+            pending.push_back((long)i);
+        }
+        size_t unassigned = currentLines.size();
+
+        while (unassigned > 0)
+        {
+            // Find the commit that produced the current version of the file.
+            CommitGraphEntry node;
+            ObjectId parentHash;
+            bool parentHasFile = false;
+            while (true)
+            {
+                if (!getGraphEntry(commitId, node))
+                {
+                    return false;
+                }
+                if (!node.hasParent || !commits.contains(node.parentId))
+                {
+                    break; // root of the available history
+                }
+                if (!node.changedPaths.mightContain(path))
+                {
+                    commitId = node.parentId;
+                    continue;
+                }
+                parentHasFile = readFileAt(node.parentId, path, parentHash);
+                if (parentHasFile && parentHash == currentHash)
+                {
+                    commitId = node.parentId; // Bloom false positive
+                    continue;
+                }
+                break;
+            }
+
+            SimpleVec<std::string> parentLines;
+            if (parentHasFile)
+            {
+                const std::string *parentContent = findBlob(parentHash);
+                if (!parentContent)
+                {
+                    return false;
+                }
+                parentLines = splitLines(*parentContent);
+            }
+
+            SimpleVec<long> match = matchLines(parentLines, currentLines);
+            std::string commitHex = commitId.toHex();
+            SimpleVec<long> parentPending;
+            for (size_t i = 0; i < parentLines.size(); ++i)
+            {
+                parentPending.push_back(-1);
+            }
+            for (size_t i = 0; i < currentLines.size(); ++i)
+            {
+                if (pending[i] < 0)
+                {
+                    continue;
+                }
+                if (match[i] >= 0)
+                {
+                    parentPending[(size_t)match[i]] = pending[i];
+                }
+                else
+                {
+                    result[(size_t)pending[i]].commitId = commitHex;
+                    result[(size_t)pending[i]].timestamp = node.timestamp;
+                    unassigned--;
+                }
+            }
+
+            if (!parentHasFile)
+            {
+                break;
+            }
+            commitId = node.parentId;
+            currentHash = parentHash;
+            currentLines = parentLines;
+            pending = parentPending;
+        }
+        return true;
+    }
+
+    // Shared by open() and openReadOnly(); see those for the differences.
+    OpenResult openLog(const std::string &path, bool readOnlyOpen)
+    {
+        OpenResult result;
+        if (!readOnlyOpen && ::mkdir(path.c_str(), 0755) != 0 && errno != EEXIST)
+        {
+            result.status = Status::StorageError;
+            result.error = "cannot create repository directory: " + std::string(std::strerror(errno));
+            return result;
+        }
+        if (!(readOnlyOpen ? wal.openReadOnly(path + "/log") : wal.open(path + "/log")))
+        {
+            result.status = Status::StorageError;
+            result.error = readOnlyOpen ? "no repository at " + path + " (" + wal.lastError() + ")" : wal.lastError();
+            return result;
+        }
+        repoPath = path;
+        readOnly = readOnlyOpen;
+        commits.attach(&wal);
+        objectStore.attach(&wal);
+        commitGraph.attach(&wal);
+        timeIndex.clear();
+        timeIndexReady = false;
+        stagingArea.clear();
+        headCommitId.clear();
+        unsyncedCommits = 0;
+        headDirty = false;
+        delete backingStore;
+        backingStore = nullptr;
+        backingPath.clear();
+        sparsePaths.clear();
+        unloggedBlobs.clear();
+        readPartialConfig();
+
+        // HEAD holds the last published ref and the log size it was published
+        // against. Records below that size were fsynced and need no checksum
+        // pass; the log is never behind HEAD, so a newer logged HEAD wins.
+        std::string publishedHead;
+        uint64_t publishedLogSize = 0;
+        std::string headFile;
+        if (readWholeFile(path + "/HEAD", headFile))
+        {
+            std::istringstream in(headFile);
+            in >> publishedHead >> publishedLogSize;
+        }
+
+        std::string loggedHead;
+        result.records = wal.scan(publishedLogSize, [&](char type, const std::string &key, uint64_t offset)
+        {
+            if (type == WriteAheadLog::RECORD_OBJECT)
+            {
+                objectStore.index(key, offset);
+            }
+            else if (type == WriteAheadLog::RECORD_COMMIT)
+            {
+                commits.index(key, offset);
+            }
+            else if (type == WriteAheadLog::RECORD_GRAPH)
+            {
+                commitGraph.index(key, offset);
+            }
+            else if (type == WriteAheadLog::RECORD_HEAD && commits.contains(key))
+            {
+                loggedHead = key;
+            }
+        });
+        result.discardedBytes = wal.discardedBytes();
+        result.logShorterThanHead = publishedLogSize > wal.size();
+        if (wal.damagedBeforeTrustedPrefix())
+        {
+            // Refuse rather than recover a shortened history that a later
+            // init() or commit() would overwrite. The file is left as found.
+            result.status = Status::StorageError;
+            result.error = wal.lastError();
+            wal.close();
+            commits.attach(nullptr);
+            objectStore.attach(nullptr);
+            commitGraph.attach(nullptr);
+            repoPath.clear();
+            readOnly = false;
+            backingPath.clear();
+            sparsePaths.clear();
+            initialized = false;
+            return result;
+        }
+
+        if (commits.contains(publishedHead))
+        {
+            headCommitId = publishedHead;
+        }
+        if (!loggedHead.empty() && loggedHead != headCommitId)
+        {
+            headCommitId = loggedHead;
+            headDirty = true;
+        }
+
+        initialized = !headCommitId.empty();
+        result.recovered = initialized;
+        result.commitCount = commits.size();
+        result.headCommitId = headCommitId;
+        if (initialized && !sync())
+        {
+            result.status = Status::StorageError;
+            result.error = wal.lastError();
+        }
+        return result;
+    }
+
+public:
+    static const size_t DEFAULT_COMMIT_CACHE = 1024;
+    static const size_t DEFAULT_BLOB_CACHE = 256;
+    static const size_t DEFAULT_GRAPH_CACHE = 65536;
+
+    Gitlet()
+        : initialized(false), objectStore(DEFAULT_BLOB_CACHE), commits(DEFAULT_COMMIT_CACHE),
+          commitGraph(DEFAULT_GRAPH_CACHE), timeIndexReady(false),
+          groupCommitSize(1), unsyncedCommits(0), headDirty(false), readOnly(false),
+          backingStore(nullptr), fetchedBlobs(0), unloggedBlobs(DEFAULT_BLOB_CACHE) {}
+
+    Gitlet(const Gitlet &) = delete;
+    Gitlet &operator=(const Gitlet &) = delete;
+
+    ~Gitlet()
+    {
+        sync();
+        delete backingStore;
+    }
+
+    // --- Persistence ---
+
+    // Attaches the repository to a directory. An existing log is indexed
+    // (dropping any torn tail) and the repository resumes where it stopped.
+    // Only record offsets are loaded; commits, their manifests and blobs are
+    // faulted in from the log when first touched.
+    OpenResult open(const std::string &path)
+    {
+        return openLog(path, false);
+    }
+
+    // Attaches to an existing repository without ever writing to it: no
+    // directory or log is created, a torn tail is left in place and HEAD is
+    // never republished. Clone sources and partial-clone backing stores are
+    // opened this way; commands that would write fail with StorageError.
+    OpenResult openReadOnly(const std::string &path)
+    {
+        return openLog(path, true);
+    }
+
+    // Bounds how many commits (with their manifests) and blobs stay resident
+    // once the repository is backed by a log.
+    void setCacheCapacity(size_t commitCapacity, size_t blobCapacity)
+    {
+        commits.setCacheCapacity(commitCapacity);
+        objectStore.setCacheCapacity(blobCapacity);
+    }
+
+    size_t loadedCommitCount() const
+    {
+        return commits.loadedCount();
+    }
+
+    // Group commit: fsync the log once per batchSize commits instead of after
+    // each one. Commits in an unsynced batch can be lost by a crash, but the
+    // log never recovers to a half-written state.
+    void setGroupCommit(size_t batchSize)
+    {
+        groupCommitSize = batchSize == 0 ? 1 : batchSize;
+        if (unsyncedCommits >= groupCommitSize)
+        {
+            sync();
+        }
+    }
+
+    // Makes all logged work durable and publishes HEAD.
+    bool sync()
+    {
+        if (!isPersistent() || readOnly)
+        {
+            return true;
+        }
+        if (!wal.sync())
+        {
+            return false;
+        }
+        unsyncedCommits = 0;
+        if (headDirty)
+        {
+            std::ostringstream headFile;
+            headFile << headCommitId << "\n"
+                     << wal.durableSize() << "\n";
+            if (!writeFileAtomically(repoPath, "HEAD", headFile.str()))
+            {
+                return false;
+            }
+            headDirty = false;
+        }
+        return true;
+    }
+
+    // --- Core Commands ---
+    // None of these print; results are rendered by ConsoleRenderer.
+
+    InitResult init()
+    {
+        InitResult result;
+        if (initialized)
+        {
+            result.status = Status::AlreadyInitialized;
+            result.commitId = headCommitId;
+            return result;
+        }
+        commits.clear(); // Ensure clean state
+        commitGraph.clear();
+        timeIndex.clear();
+        timeIndexReady = false;
+        stagingArea.clear();
+        objectStore.clear();
+
+        Commit initialCommit;
+        initialCommit.message = "initial commit";
+        initialCommit.timestamp = std::time(nullptr);
+        initialCommit.parentId = "";
+        // trackedFiles is empty by default constructor of SimpleMap
+
+        initialCommit.id = generateCommitId(initialCommit);
+
+        // Insert the Commit object (requires Commit copyability)
+        if (!commits.insert(initialCommit.id, initialCommit))
+        {
+            result.status = Status::StorageError;
+            return result;
+        }
+        recordGraphEntry(initialCommit, SimpleVec<std::string>());
+
+        headCommitId = initialCommit.id;
+        initialized = true;
+        unsyncedCommits++;
+        if (!persistHead())
+        {
+            result.status = Status::StorageError;
+        }
+
+        result.commitId = headCommitId;
+        return result;
+    }
+
+    static std::string hashContent(const std::string &content)
+    {
+        return hashToString(simpleHash(content));
+    }
+
+    AddResult add(const std::string &filename, const std::string &content)
+    {
+        return stageFile(filename, content, hashContent(content));
+    }
+
+    // Stages content whose hash the caller already computed (see
+    // hashContent), so hashing can happen off the repository's thread.
+    AddResult stageFile(const std::string &filename, const std::string &content, const std::string &contentHash)
+    {
+        AddResult result;
+        result.contentHash = contentHash;
+        if (!initialized)
+        {
+            result.status = Status::NotInitialized;
+            return result;
+        }
+
+        // Store blob if new (a malformed hash is never stored)
+        ObjectId contentId;
+        if (!ObjectId::fromHex(contentHash, contentId) ||
+            (!objectStore.contains(contentId) && !objectStore.insert(contentId, content)))
+        {
+            result.status = Status::StorageError;
+            return result;
+        }
+
+        // Check if identical to version in HEAD commit
+        Commit *head = getHeadCommit();
+        bool identicalToHead = false;
+        if (head)
+        {
+            const ObjectId *headContentHashPtr = head->trackedFiles.find(filename);
+            if (headContentHashPtr && *headContentHashPtr == contentId)
+            {
+                identicalToHead = true;
+            }
+        }
+
+        // Check staging area
+        const ObjectId *stagedContentHashPtr = stagingArea.find(filename);
+
+        // If identical to head, remove from staging
+        if (identicalToHead)
+        {
+            if (stagedContentHashPtr)
+            { // Only remove if it was actually staged
+                stagingArea.remove(filename);
+            }
+        }
+        else if (!stagedContentHashPtr || *stagedContentHashPtr != contentId)
+        {
+            // Stage the file: filename -> contentHash
+            stagingArea.insert(filename, contentId);
+            result.staged = true;
+        }
+        return result;
+    }
+
+    CommitResult commit(const std::string &message)
+    {
+        CommitResult result;
+        if (!initialized)
+        {
+            result.status = Status::NotInitialized;
+            return result;
+        }
+        if (stagingArea.empty())
+        {
+            result.status = Status::NothingToCommit;
+            return result;
         }
 
         Commit *parentCommit = getHeadCommit();
         if (!parentCommit)
         {
-            std::cerr << "Critical Error: HEAD commit not found!" << std::endl;
+            result.status = Status::NotFound; // HEAD commit missing
+            return result;
+        }
+
+        Commit newCommit;
+        newCommit.message = message;
+        newCommit.timestamp = std::time(nullptr);
+        newCommit.parentId = headCommitId;
+
+        // Inherit tracked files from parent (uses SimpleMap assignment operator)
+        newCommit.trackedFiles = parentCommit->trackedFiles;
+
+        // Apply staged changes
+        SimpleVec<std::string> stagedKeys = stagingArea.getKeys();
+        for (size_t i = 0; i < stagedKeys.size(); ++i)
+        {
+            const std::string &filename = stagedKeys[i];
+            newCommit.trackedFiles.insert(filename, *stagingArea.find(filename)); // Insert/update in commit
+        }
+
+        newCommit.id = generateCommitId(newCommit);
+        if (!commits.insert(newCommit.id, newCommit)) // Insert copy
+        {
+            result.status = Status::StorageError;
+            return result;
+        }
+        recordGraphEntry(newCommit, stagedKeys);
+        addToTimeIndex(newCommit);
+        headCommitId = newCommit.id;
+        stagingArea.clear();
+        unsyncedCommits++;
+        if (!persistHead())
+        {
+            result.status = Status::StorageError;
+        }
+
+        result.commitId = newCommit.id;
+        return result;
+    }
+
+    // Filtered history from HEAD, produced one entry at a time. The walk runs
+    // over commit-graph records; a time range is resolved against the
+    // timestamp-sorted index up front, and the walk ends once every commit in
+    // range has been seen or, as in git, at the first commit older than
+    // since (so in-range commits HEAD cannot reach never keep it going). A
+    // path is checked against each commit's
+    // changed-path Bloom filter. Manifests are only loaded for commits that
+    // pass both, and only when next() reaches them.
+    class LogIterator
+    {
+    private:
+        friend class Gitlet;
+
+        Gitlet *repo;
+        LogOptions options;
+        SimpleMap<ObjectId, bool> inRange;
+        size_t remainingInRange;
+        ObjectId nextCommitId;
+        bool hasNext;
+        size_t produced;
+        Status state;
+
+    public:
+        LogIterator() : repo(nullptr), remainingInRange(0), nextCommitId(), hasNext(false), produced(0), state(Status::Ok) {}
+
+        // NotInitialized, or NotFound if history is broken part way through.
+        Status status() const
+        {
+            return state;
+        }
+
+        bool next(LogEntry &entry)
+        {
+            while (repo && hasNext && produced < options.maxCount)
+            {
+                ObjectId commitId = nextCommitId;
+                CommitGraphEntry node;
+                if (!repo->getGraphEntry(commitId, node))
+                {
+                    state = Status::NotFound;
+                    break;
+                }
+                nextCommitId = node.parentId; // Move to parent
+                hasNext = node.hasParent;
+                if (node.timestamp < options.since)
+                {
+                    break; // the rest of history is older still
+                }
+
+                bool show = true;
+                if (options.hasTimeRange())
+                {
+                    show = inRange.contains(commitId);
+                    if (show && --remainingInRange == 0)
+                    {
+                        hasNext = false; // every commit in range seen
+                    }
+                }
+                if (show && !options.path.empty())
+                {
+                    show = repo->commitTouchesPath(commitId, node, options.path);
+                }
+                if (show)
+                {
+                    const Commit *commit = repo->getCommit(commitId);
+                    if (!commit)
+                    {
+                        state = Status::NotFound;
+                        break;
+                    }
+                    entry = makeLogEntry(*commit, options.path);
+                    produced++;
+                    return true;
+                }
+            }
+            repo = nullptr;
+            return false;
+        }
+    };
+
+    LogIterator log(const LogOptions &options = LogOptions())
+    {
+        LogIterator it;
+        it.options = options;
+        if (!initialized)
+        {
+            it.state = Status::NotInitialized;
+            return it;
+        }
+        it.repo = this;
+        it.hasNext = ObjectId::fromHex(headCommitId, it.nextCommitId);
+        if (options.hasTimeRange())
+        {
+            ensureTimeIndex();
+            size_t first = timeIndexBound(options.since, false);
+            size_t last = timeIndexBound(options.until, true);
+            for (size_t i = first; i < last; ++i)
+            {
+                it.inRange.insert(timeIndex[i].commitId, true);
+            }
+            it.remainingInRange = it.inRange.size();
+            if (it.inRange.empty())
+            {
+                it.hasNext = false;
+            }
+        }
+        return it;
+    }
+
+    // Materialises a whole log query.
+    Status collectLog(const LogOptions &options, SimpleVec<LogEntry> &entries)
+    {
+        entries.clear();
+        LogIterator it = log(options);
+        LogEntry entry;
+        while (it.next(entry))
+        {
+            entries.push_back(entry);
+        }
+        return it.status();
+    }
+
+    // Each line of path at HEAD with the commit that last changed it.
+    BlameResult blame(const std::string &path)
+    {
+        BlameResult result;
+        if (!initialized)
+        {
+            result.status = Status::NotInitialized;
+            return result;
+        }
+        if (!computeBlame(path, result.lines))
+        {
+            result.status = Status::NotFound;
+            result.lines.clear();
+        }
+        return result;
+    }
+
+    CheckoutResult checkout(const std::string &commitIdOrPrefix)
+    {
+        CheckoutResult result;
+        if (!initialized)
+        {
+            result.status = Status::NotInitialized;
+            return result;
+        }
+
+        // Check for exact match first
+        if (commits.contains(commitIdOrPrefix))
+        {
+            result.commitId = commitIdOrPrefix;
+        }
+        else
+        {
+            // Try prefix matching
+            SimpleVec<std::string> allCommitIds = commits.getKeys();
+            int matchCount = 0;
+            for (size_t i = 0; i < allCommitIds.size(); ++i)
+            {
+                const std::string &id = allCommitIds[i];
+                // Check if id starts with commitIdOrPrefix
+                if (id.rfind(commitIdOrPrefix, 0) == 0)
+                {
+                    matchCount++;
+                    result.commitId = id; // Store potential match
+                }
+            }
+
+            if (matchCount != 1)
+            {
+                result.status = matchCount == 0 ? Status::NotFound : Status::Ambiguous;
+                result.commitId.clear();
+                return result;
+            }
+            // Exactly one prefix match found, result.commitId holds the full ID
+            result.resolvedFromPrefix = true;
+        }
+
+        headCommitId = result.commitId;
+        if (!persistHead())
+        {
+            result.status = Status::StorageError;
+        }
+
+        if (!stagingArea.empty())
+        {
+            stagingArea.clear();
+            result.stagingCleared = true;
+        }
+        return result;
+    }
+
+    FileState fileState()
+    {
+        FileState state;
+        if (!initialized)
+        {
+            state.status = Status::NotInitialized;
+            return state;
+        }
+        state.headCommitId = headCommitId;
+        Commit *head = getHeadCommit();
+        if (!head)
+        {
+            state.status = Status::NotFound;
+            return state;
+        }
+
+        // Copy the manifest first: loading blobs may evict HEAD from the cache.
+        Manifest trackedFiles = head->trackedFiles;
+        SimpleVec<std::string> trackedKeys = trackedFiles.getKeys();
+        bubbleSort(trackedKeys); // Sort for consistent output
+        for (size_t i = 0; i < trackedKeys.size(); ++i)
+        {
+            TrackedFile file;
+            file.filename = trackedKeys[i];
+            const ObjectId &contentHash = *trackedFiles.find(trackedKeys[i]);
+            file.contentHash = contentHash.toHex();
+            file.outsideSparse = !inSparseSet(file.filename);
+            const std::string *contentPtr = file.outsideSparse ? nullptr : findBlob(contentHash);
+            if (contentPtr)
+            {
+                file.content = *contentPtr;
+                file.contentAvailable = true;
+            }
+            state.tracked.push_back(file);
+        }
+
+        SimpleVec<std::string> stagedKeys = stagingArea.getKeys();
+        bubbleSort(stagedKeys); // Sort for consistent output
+        for (size_t i = 0; i < stagedKeys.size(); ++i)
+        {
+            FileEntry file;
+            file.filename = stagedKeys[i];
+            file.contentHash = stagingArea.find(stagedKeys[i])->toHex();
+            state.staged.push_back(file);
+        }
+        return state;
+    }
+
+    // --- Bundles ---
+
+    // Commit IDs a receiver offers during negotiation: HEAD, then ancestors
+    // at exponentially growing distances, then the root. The sender stops at
+    // the first of these it knows, so it never sends history both sides have
+    // (at the cost of a few extra commits when the common point falls between
+    // two advertised ones).
+    SimpleVec<std::string> advertiseHaves(size_t maxHaves = 32)
+    {
+        SimpleVec<std::string> haves;
+        if (!initialized)
+        {
+            return haves;
+        }
+        ObjectId commitId;
+        bool more = ObjectId::fromHex(headCommitId, commitId);
+        ObjectId last = commitId;
+        size_t depth = 0;
+        size_t nextAdvertised = 0;
+        while (more && haves.size() + 1 < maxHaves)
+        {
+            if (depth == nextAdvertised)
+            {
+                haves.push_back(commitId.toHex());
+                nextAdvertised = nextAdvertised == 0 ? 1 : nextAdvertised * 2;
+            }
+            last = commitId;
+            CommitGraphEntry node;
+            if (!getGraphEntry(commitId, node))
+            {
+                break;
+            }
+            more = node.hasParent && commits.contains(node.parentId);
+            commitId = node.parentId;
+            depth++;
+        }
+        std::string lastHex = last.toHex();
+        if (!haves.empty() && haves[haves.size() - 1] != lastHex)
+        {
+            haves.push_back(lastHex);
+        }
+        return haves;
+    }
+
+    // Streams the commits in range (oldest first) into out. Each commit is
+    // preceded by the blobs it introduces that the receiver lacks; a blob is
+    // sent as a delta against the same path's previous version when that is
+    // smaller. The stream ends with a CRC-32 of everything before it.
+    BundleResult exportBundle(std::ostream &out, const BundleRange &range)
+    {
+        BundleResult result;
+        if (!initialized)
+        {
+            result.status = Status::NotInitialized;
+            return result;
+        }
+        result.tip = range.tip.empty() ? headCommitId : range.tip;
+        if (!commits.contains(result.tip))
+        {
+            result.status = Status::NotFound;
+            result.error = "unknown tip " + result.tip;
+            return result;
+        }
+
+        SimpleMap<ObjectId, bool> haveSet;
+        for (size_t i = 0; i < range.haves.size(); ++i)
+        {
+            ObjectId id;
+            if (ObjectId::fromHex(range.haves[i], id) && commits.contains(id))
+            {
+                haveSet.insert(id, true);
+            }
+        }
+        SimpleVec<ObjectId> chain; // newest first
+        ObjectId commitId;
+        bool more = ObjectId::fromHex(result.tip, commitId);
+        while (more)
+        {
+            if (haveSet.contains(commitId))
+            {
+                result.boundary = commitId.toHex();
+                break;
+            }
+            chain.push_back(commitId);
+            CommitGraphEntry node;
+            if (!getGraphEntry(commitId, node))
+            {
+                result.status = Status::NotFound;
+                result.error = "missing commit " + commitId.toHex();
+                return result;
+            }
+            commitId = node.parentId;
+            more = node.hasParent;
+        }
+
+        // Blobs the receiver is known to hold: the boundary's, then ours as sent.
+        SimpleMap<ObjectId, bool> receiverHas;
+        Manifest parentFiles;
+        if (!result.boundary.empty())
+        {
+            const Commit *boundary = getCommit(result.boundary);
+            if (!boundary)
+            {
+                result.status = Status::NotFound;
+                result.error = "cannot read boundary commit " + result.boundary;
+                return result;
+            }
+            parentFiles = boundary->trackedFiles;
+            SimpleVec<std::string> names = parentFiles.getKeys();
+            for (size_t i = 0; i < names.size(); ++i)
+            {
+                receiverHas.insert(*parentFiles.find(names[i]), true);
+            }
+        }
+
+        uint32_t crc = 0;
+        std::string magic(BUNDLE_MAGIC);
+        out.write(magic.data(), (std::streamsize)magic.size());
+        crc = crc32Update(crc, magic.data(), magic.size());
+        result.bytes = magic.size();
+        std::string tipPayload;
+        appendString(tipPayload, result.tip);
+        writeBundleRecord(out, 'T', tipPayload, crc, result.bytes);
+
+        for (size_t i = chain.size(); i-- > 0;)
+        {
+            const Commit *loaded = getCommit(chain[i]);
+            if (!loaded)
+            {
+                result.status = Status::NotFound;
+                result.error = "missing commit " + chain[i].toHex();
+                return result;
+            }
+            Commit commit = *loaded;
+            if (i == chain.size() - 1 && result.boundary.empty() && !commit.parentId.empty())
+            {
+                // Our history stops at a shallow root; tell the receiver so it
+                // does not expect the parent.
+                std::string shallowPayload;
+                appendString(shallowPayload, commit.id);
+                writeBundleRecord(out, 'S', shallowPayload, crc, result.bytes);
+            }
+            SimpleVec<std::string> names = commit.trackedFiles.getKeys();
+            bubbleSort(names);
+            for (size_t j = 0; j < names.size(); ++j)
+            {
+                ObjectId contentHash = *commit.trackedFiles.find(names[j]);
+                if (receiverHas.contains(contentHash))
+                {
+                    continue;
+                }
+                const std::string *contentPtr = findBlob(contentHash);
+                if (!contentPtr)
+                {
+                    result.status = Status::NotFound;
+                    result.error = "missing blob " + contentHash.toHex();
+                    return result;
+                }
+                std::string content = *contentPtr;
+
+                std::string payload;
+                appendString(payload, contentHash.toHex());
+                const ObjectId *baseHash = parentFiles.find(names[j]);
+                const std::string *base = baseHash ? objectStore.find(*baseHash) : nullptr;
+                std::string baseHex;
+                std::string delta;
+                if (base)
+                {
+                    baseHex = baseHash->toHex();
+                    delta = encodeDelta(*base, content);
+                }
+                if (base && delta.size() + baseHex.size() < content.size())
+                {
+                    appendString(payload, baseHex);
+                    appendString(payload, delta);
+                    writeBundleRecord(out, 'D', payload, crc, result.bytes);
+                    result.deltas++;
+                }
+                else
+                {
+                    appendString(payload, content);
+                    writeBundleRecord(out, 'B', payload, crc, result.bytes);
+                }
+                receiverHas.insert(contentHash, true);
+                result.blobs++;
+            }
+            writeBundleRecord(out, 'C', serializeCommit(commit), crc, result.bytes);
+            result.commits++;
+            parentFiles = commit.trackedFiles;
+        }
+
+        std::string trailer;
+        appendU32(trailer, crc);
+        writeBundleRecord(out, 'E', trailer, crc, result.bytes);
+        out.flush();
+        if (!out)
+        {
+            result.status = Status::StorageError;
+            result.error = "bundle write failed";
+        }
+        return result;
+    }
+
+    // Reads a bundle written by exportBundle. Three stages overlap: a decoder
+    // thread parses frames and checks the stream CRC, a pool of hashThreads
+    // workers re-hashes every blob, and this thread resolves deltas, stores
+    // verified blobs and checks each commit's ID, parent and blobs before
+    // adding it. HEAD is left alone unless the repository was empty, in which
+    // case it starts at the bundle tip. Objects applied before an error stay
+    // (they are verified and content-addressed). A bundle from a shallow
+    // clone names its shallow root, which becomes one here as well; a partial
+    // clone resolves delta bases and unsent blobs through its backing store.
+    BundleResult importBundle(std::istream &in, size_t hashThreads = 0)
+    {
+        BundleResult result;
+        if (hashThreads == 0)
+        {
+            hashThreads = std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 1;
+        }
+
+        struct Frame
+        {
+            char type;
+            std::string payload;
+            Frame() : type(0) {}
+        };
+        struct PendingBlob
+        {
+            std::string contentHash;
+            std::string content;
+            int state; // 0 hashing, 1 verified, 2 mismatch
+        };
+
+        BoundedQueue<Frame> frames(64);
+        std::string decodeError;
+        std::thread decoder([&in, &frames, &decodeError] {
+            uint32_t crc = 0;
+            char magic[8];
+            in.read(magic, sizeof(magic));
+            if (in.gcount() != (std::streamsize)sizeof(magic) || std::string(magic, sizeof(magic)) != BUNDLE_MAGIC)
+            {
+                decodeError = "not a bundle";
+                frames.close();
+                return;
+            }
+            crc = crc32Update(crc, magic, sizeof(magic));
+            // An exception escaping this thread would terminate the process.
+            try
+            {
+                while (true)
+                {
+                    char header[5];
+                    in.read(header, sizeof(header));
+                    if (in.gcount() != (std::streamsize)sizeof(header))
+                    {
+                        decodeError = "truncated bundle";
+                        break;
+                    }
+                    std::string lengthBytes(header + 1, 4);
+                    ByteReader reader(lengthBytes);
+                    uint32_t length = reader.readU32();
+                    if (length > MAX_BUNDLE_RECORD)
+                    {
+                        decodeError = "corrupt bundle record";
+                        break;
+                    }
+                    // The length is unverified until the trailer, so the payload
+                    // only grows as bytes actually arrive.
+                    Frame frame;
+                    frame.type = header[0];
+                    bool complete = true;
+                    while (frame.payload.size() < length)
+                    {
+                        size_t offset = frame.payload.size();
+                        size_t chunk = length - offset < BUNDLE_READ_CHUNK ? length - offset : BUNDLE_READ_CHUNK;
+                        frame.payload.resize(offset + chunk);
+                        in.read(&frame.payload[offset], (std::streamsize)chunk);
+                        if (in.gcount() != (std::streamsize)chunk)
+                        {
+                            complete = false;
+                            break;
+                        }
+                    }
+                    if (!complete)
+                    {
+                        decodeError = "truncated bundle";
+                        break;
+                    }
+                    if (frame.type == 'E')
+                    {
+                        ByteReader trailer(frame.payload);
+                        if (trailer.readU32() != crc)
+                        {
+                            decodeError = "bundle checksum mismatch";
+                            break;
+                        }
+                        frames.push(frame);
+                        break;
+                    }
+                    crc = crc32Update(crc, header, sizeof(header));
+                    crc = crc32Update(crc, frame.payload.data(), frame.payload.size());
+                    if (!frames.push(frame))
+                    {
+                        break; // importer gave up
+                    }
+                }
+            }
+            catch (const std::bad_alloc &)
+            {
+                decodeError = "bundle record too large";
+            }
+            frames.close();
+        });
+
+        ThreadPool *hashPool = new ThreadPool(hashThreads);
+        std::mutex verifyMutex;
+        std::condition_variable verified;
+        SimpleVec<PendingBlob *> pending;
+        size_t pendingHead = 0;
+        SimpleMap<std::string, std::string> unstored; // decoded but not yet stored, for delta bases
+        SimpleMap<std::string, bool> shallowRoots;    // commits the sender's history stops at
+
+        // Stores verified blobs in bundle order; with waitAll, blocks until
+        // every queued blob has been hashed.
+        auto storeVerified = [&](bool waitAll) -> bool
+        {
+            while (pendingHead < pending.size())
+            {
+                PendingBlob *blob = pending[pendingHead];
+                {
+                    std::unique_lock<std::mutex> lock(verifyMutex);
+                    if (blob->state == 0 && !waitAll)
+                    {
+                        return true;
+                    }
+                    verified.wait(lock, [blob] { return blob->state != 0; });
+                }
+                if (blob->state == 2)
+                {
+                    result.error = "blob " + blob->contentHash + " does not match its content";
+                    return false;
+                }
+                if (!objectStore.contains(blob->contentHash))
+                {
+                    if (!objectStore.insert(blob->contentHash, blob->content))
+                    {
+                        result.error = "cannot store blob " + blob->contentHash;
+                        return false;
+                    }
+                    result.blobs++;
+                }
+                unstored.remove(blob->contentHash);
+                delete blob;
+                pending[pendingHead++] = nullptr;
+            }
+            return true;
+        };
+
+        bool ok = true;
+        bool ended = false;
+        Frame frame;
+        while (ok && frames.pop(frame))
+        {
+            ByteReader reader(frame.payload);
+            if (frame.type == 'T')
+            {
+                result.tip = reader.readString();
+            }
+            else if (frame.type == 'B' || frame.type == 'D')
+            {
+                PendingBlob *blob = new PendingBlob();
+                blob->state = 0;
+                blob->contentHash = reader.readString();
+                if (frame.type == 'B')
+                {
+                    blob->content = reader.readString();
+                }
+                else
+                {
+                    std::string baseHash = reader.readString();
+                    std::string delta = reader.readString();
+                    const std::string *base = unstored.find(baseHash);
+                    if (!base)
+                    {
+                        base = findBlob(baseHash);
+                    }
+                    if (!base || !applyDelta(*base, delta, blob->content))
+                    {
+                        result.error = "cannot resolve delta for " + blob->contentHash;
+                        ok = false;
+                    }
+                    result.deltas++;
+                }
+                if (!reader.ok)
+                {
+                    result.error = "malformed blob record";
+                    ok = false;
+                }
+                if (!ok)
+                {
+                    delete blob;
+                    break;
+                }
+                unstored.insert(blob->contentHash, blob->content);
+                pending.push_back(blob);
+                hashPool->submit([blob, &verifyMutex, &verified] {
+                    bool match = hashContent(blob->content) == blob->contentHash;
+                    std::lock_guard<std::mutex> lock(verifyMutex);
+                    blob->state = match ? 1 : 2;
+                    verified.notify_all();
+                });
+                ok = storeVerified(false);
+            }
+            else if (frame.type == 'S')
+            {
+                shallowRoots.insert(reader.readString(), true);
+                if (!reader.ok)
+                {
+                    result.error = "malformed shallow record";
+                    ok = false;
+                }
+            }
+            else if (frame.type == 'C')
+            {
+                ok = storeVerified(true) && importCommit(frame.payload, shallowRoots, result);
+            }
+            else if (frame.type == 'E')
+            {
+                ended = true;
+            }
+            else
+            {
+                result.error = std::string("unknown bundle record '") + frame.type + "'";
+                ok = false;
+            }
+        }
+        ok = ok && storeVerified(true);
+
+        frames.close();
+        decoder.join();
+        delete hashPool; // waits for outstanding hash jobs
+        for (size_t i = pendingHead; i < pending.size(); ++i)
+        {
+            delete pending[i];
+        }
+
+        if (ok && !ended)
+        {
+            result.error = decodeError.empty() ? "truncated bundle" : decodeError;
+            ok = false;
+        }
+        if (ok && !initialized && commits.contains(result.tip))
+        {
+            headCommitId = result.tip;
+            initialized = true;
+            ok = persistHead();
+            if (!ok)
+            {
+                result.error = "cannot record HEAD";
+            }
+        }
+        if (!sync() && ok)
+        {
+            result.error = "cannot sync the log";
+            ok = false;
+        }
+        if (!ok)
+        {
+            result.status = Status::StorageError;
+        }
+        return result;
+    }
+
+    // --- Shallow and partial clones ---
+
+    // Initializes this empty repository from the one at sourceDir, copying
+    // only the newest options.depth first-parent commits and, unless
+    // blobless, the blobs under the sparse paths. The oldest copied commit
+    // becomes a shallow root: history walks (log, blame, bundles) stop there.
+    // Blobs left behind stay in the source, which is remembered as the
+    // backing store and consulted whenever one is needed. A partial source
+    // is read through its own backing store; a blob it cannot supply fails a
+    // non-blobless clone with NotFound.
+    CloneResult clone(const std::string &sourceDir, const CloneOptions &options = CloneOptions())
+    {
+        CloneResult result;
+        if (initialized)
+        {
+            result.status = Status::AlreadyInitialized;
+            return result;
+        }
+        Gitlet *source = new Gitlet();
+        OpenResult opened = source->openReadOnly(sourceDir);
+        if (opened.status != Status::Ok || !source->initialized)
+        {
+            result.status = opened.status != Status::Ok ? opened.status : Status::NotFound;
+            result.error = opened.status != Status::Ok ? opened.error : "no repository at " + sourceDir;
+            delete source;
+            return result;
+        }
+
+        SimpleVec<ObjectId> chain; // newest first
+        ObjectId commitId;
+        bool more = ObjectId::fromHex(source->headCommitId, commitId);
+        while (more && (options.depth == 0 || chain.size() < options.depth))
+        {
+            CommitGraphEntry node;
+            if (!source->getGraphEntry(commitId, node))
+            {
+                result.status = Status::NotFound;
+                result.error = "source is missing commit " + commitId.toHex();
+                delete source;
+                return result;
+            }
+            chain.push_back(commitId);
+            commitId = node.parentId;
+            more = node.hasParent;
+        }
+        result.shallow = more;
+
+        sparsePaths.clear();
+        for (size_t i = 0; i < options.sparsePaths.size(); ++i)
+        {
+            sparsePaths.push_back(normalizeSparsePath(options.sparsePaths[i]));
+        }
+        for (size_t i = chain.size(); i-- > 0;)
+        {
+            const Commit *loaded = source->getCommit(chain[i]);
+            CommitGraphEntry node;
+            if (!loaded || !source->getGraphEntry(chain[i], node))
+            {
+                result.status = Status::NotFound;
+                result.error = "source is missing commit " + chain[i].toHex();
+                break;
+            }
+            Commit commit = *loaded;
+            SimpleVec<std::string> names = commit.trackedFiles.getKeys();
+            if (!options.blobless)
+            {
+                for (size_t j = 0; j < names.size(); ++j)
+                {
+                    const ObjectId &contentHash = *commit.trackedFiles.find(names[j]);
+                    if (!inSparseSet(names[j]) || objectStore.contains(contentHash))
+                    {
+                        continue;
+                    }
+                    // The source may be partial itself; fetch through it.
+                    const std::string *content = source->findBlob(contentHash);
+                    if (!content)
+                    {
+                        result.status = Status::NotFound;
+                        result.error = "source cannot supply blob " + contentHash.toHex() + " of " + names[j];
+                        break;
+                    }
+                    if (!objectStore.insert(contentHash, *content))
+                    {
+                        result.status = Status::StorageError;
+                        result.error = "cannot store blob " + contentHash.toHex();
+                        break;
+                    }
+                    result.blobs++;
+                }
+                if (result.status != Status::Ok)
+                {
+                    break;
+                }
+            }
+            if (i == chain.size() - 1 && result.shallow)
+            {
+                // Cut the graph here; the whole tree counts as changed.
+                node.hasParent = false;
+                node.changedPaths = BloomFilter::build(names);
+            }
+            if (!commits.insert(commit.id, commit) || !commitGraph.insert(commit.id, node))
+            {
+                result.status = Status::StorageError;
+                result.error = "cannot store commit " + commit.id;
+                break;
+            }
+            unsyncedCommits++;
+            result.commits++;
+        }
+        if (result.status != Status::Ok)
+        {
+            delete source;
+            return result;
+        }
+
+        timeIndexReady = false;
+        headCommitId = source->headCommitId;
+        initialized = true;
+        result.headCommitId = headCommitId;
+        if (options.blobless || !sparsePaths.empty())
+        {
+            // Saved absolute, so the clone can be reopened from anywhere.
+            char *resolved = ::realpath(sourceDir.c_str(), nullptr);
+            std::string resolveError = resolved ? std::string() : std::strerror(errno);
+            backingPath = resolved ? resolved : sourceDir;
+            std::free(resolved);
+            backingStore = source;
+            if (!resolveError.empty())
+            {
+                result.status = Status::StorageError;
+                result.error = "cannot resolve source path " + sourceDir + ": " + resolveError;
+            }
+            else if (!writePartialConfig())
+            {
+                result.status = Status::StorageError;
+                result.error = "cannot record the backing store";
+            }
+        }
+        else
+        {
+            delete source;
+        }
+        if (!persistHead() || !sync())
+        {
+            result.status = Status::StorageError;
+            result.error = "cannot record HEAD";
+        }
+        return result;
+    }
+
+    // Blobs a partial clone has fetched from its backing store so far.
+    size_t fetchedBlobCount() const
+    {
+        return fetchedBlobs;
+    }
+};
+
+// Buffers rendered text and hands it to the target stream in large writes,
+// so console output costs one flush per buffer rather than one per line.
+class OutputSink
+{
+private:
+    std::ostream &target;
+    std::string buffer;
+    size_t capacity;
+
+public:
+    OutputSink(std::ostream &out, size_t bufferSize = 64 * 1024) : target(out), capacity(bufferSize)
+    {
+        buffer.reserve(capacity);
+    }
+
+    OutputSink(const OutputSink &) = delete;
+    OutputSink &operator=(const OutputSink &) = delete;
+
+    ~OutputSink()
+    {
+        flush();
+    }
+
+    OutputSink &write(const std::string &text)
+    {
+        buffer += text;
+        if (buffer.size() >= capacity)
+        {
+            flush();
+        }
+        return *this;
+    }
+
+    OutputSink &operator<<(const std::string &text)
+    {
+        return write(text);
+    }
+
+    OutputSink &operator<<(const char *text)
+    {
+        return write(text);
+    }
+
+    OutputSink &operator<<(size_t value)
+    {
+        return write(std::to_string(value));
+    }
+
+    void flush()
+    {
+        if (!buffer.empty())
+        {
+            target.write(buffer.data(), (std::streamsize)buffer.size());
+            target.flush();
+            buffer.clear();
+        }
+    }
+};
+
+// Human-readable rendering of Gitlet results into an OutputSink.
+class ConsoleRenderer
+{
+private:
+    OutputSink &out;
+
+    static std::string formatTime(long timestamp, const char *format)
+    {
+        char timeBuf[80];
+        std::time_t commitTime = timestamp;
+        std::strftime(timeBuf, sizeof(timeBuf), format, std::localtime(&commitTime));
+        return timeBuf;
+    }
+
+    bool notInitialized(Status status)
+    {
+        if (status == Status::NotInitialized)
+        {
+            out << "Error: Repository not initialized. Run 'init' first.\n";
+            return true;
+        }
+        return false;
+    }
+
+public:
+    ConsoleRenderer(OutputSink &sink) : out(sink) {}
+
+    void open(const std::string &path, const OpenResult &result)
+    {
+        if (result.status == Status::StorageError)
+        {
+            out << "Error: Cannot open repository '" << path << "': " << result.error << "\n";
             return;
         }
+        if (result.discardedBytes > 0)
+        {
+            out << "Warning: Discarded " << (size_t)result.discardedBytes << " bytes of incomplete log tail.\n";
+        }
+        if (result.logShorterThanHead)
+        {
+            out << "Warning: Log is shorter than recorded in HEAD; history may be lost.\n";
+        }
+        if (result.recovered)
+        {
+            out << "Recovered repository at '" << path << "': " << result.records << " log records, "
+                << result.commitCount << " commits, HEAD " << result.headCommitId.substr(0, 7) << "\n";
+        }
+    }
 
-        Commit newCommit;
-        newCommit.message = message;
-        newCommit.timestamp = std::time(nullptr);
-        newCommit.parentId = headCommitId;
+    void init(const InitResult &result)
+    {
+        if (result.status == Status::AlreadyInitialized)
+        {
+            out << "Repository already initialized.\n";
+            return;
+        }
+        if (result.status != Status::Ok)
+        {
+            out << "Error: Could not write the initial commit.\n";
+            return;
+        }
+        out << "Initialized empty Gitlet repository.\n";
+        out << "Initial commit ID: " << result.commitId << "\n";
+    }
 
-        // Inherit tracked files from parent (uses SimpleMap assignment operator)
-        newCommit.trackedFiles = parentCommit->trackedFiles;
+    void add(const std::string &filename, const AddResult &result)
+    {
+        if (notInitialized(result.status))
+            return;
+        if (result.status == Status::StorageError)
+            out << "Error: Could not store '" << filename << "'.\n";
+        else if (result.staged)
+            out << "Staged '" << filename << "' for commit.\n";
+    }
 
-        // Apply staged changes
-        SimpleVec<std::string> stagedKeys = stagingArea.getKeys();
-        for (size_t i = 0; i < stagedKeys.size(); ++i)
+    void commit(const CommitResult &result)
+    {
+        if (notInitialized(result.status))
+            return;
+        if (result.status == Status::NothingToCommit)
+            out << "Nothing to commit, staging area is empty.\n";
+        else if (result.status == Status::NotFound)
+            out << "Critical Error: HEAD commit not found!\n";
+        else if (result.status == Status::StorageError)
+            out << "Error: Could not write commit.\n";
+        else
+            out << "Committed changes with ID: " << result.commitId << "\n";
+    }
+
+    void logEntry(const LogEntry &entry)
+    {
+        out << "Commit: " << entry.id << "\n";
+        out << "Date:   " << formatTime(entry.timestamp, "%a %b %d %H:%M:%S %Y %z") << "\n";
+        out << "Message:" << entry.message << "\n";
+        out << "Files:   ";
+        if (entry.files.empty())
         {
-            const std::string &filename = stagedKeys[i];
-            std::string *contentHashPtr = stagingArea.find(filename); // Find pointer
-            if (contentHashPtr)
-            {
-                newCommit.trackedFiles.insert(filename, *contentHashPtr); // Insert/update in commit
-            }
-            else
-            {
-                std::cerr << "Error: Staged key '" << filename << "' not found during commit." << std::endl;
-            }
+            out << "(none)";
         }
+        for (size_t i = 0; i < entry.files.size(); ++i)
+        {
+            if (i > 0)
+                out << ", ";
+            out << entry.files[i].filename << " (" << entry.files[i].contentHash.substr(0, 6) << "...)";
+        }
+        out << "\n";
+        out << "--------------------\n";
+    }
 
-        newCommit.id = generateCommitId(newCommit);
-        commits.insert(newCommit.id, newCommit); // Insert copy
-        headCommitId = newCommit.id;
-        stagingArea.clear();
-
-        std::cout << "Committed changes with ID: " << newCommit.id << std::endl;
+    void log(Gitlet::LogIterator it)
+    {
+        if (notInitialized(it.status()))
+            return;
+        out << "--- Commit History ---\n";
+        LogEntry entry;
+        while (it.next(entry))
+        {
+            logEntry(entry);
+        }
+        if (it.status() == Status::NotFound)
+        {
+            out << "Error: Commit data missing; history is incomplete.\n";
+        }
     }
 
-    void log()
+    void blame(const std::string &path, const BlameResult &result)
     {
-        if (!initialized)
+        if (notInitialized(result.status))
+            return;
+        if (result.status != Status::Ok)
         {
-            std::cout << "Error: Repository not initialized. Run 'init' first." << std::endl;
+            out << "Error: '" << path << "' is not tracked at HEAD.\n";
             return;
         }
+        out << "--- Blame: " << path << " ---\n";
+        for (size_t i = 0; i < result.lines.size(); ++i)
+        {
+            const BlameLine &line = result.lines[i];
+            out << line.commitId.substr(0, 7) << " (" << formatTime(line.timestamp, "%Y-%m-%d %H:%M:%S") << " "
+                << line.lineNumber << ") " << line.text << "\n";
+        }
+        out << "--------------------\n";
+    }
 
-        std::cout << "--- Commit History ---" << std::endl;
-        std::string currentCommitId = headCommitId;
+    void checkout(const std::string &commitIdOrPrefix, const CheckoutResult &result)
+    {
+        if (notInitialized(result.status))
+            return;
+        if (result.status == Status::NotFound)
+        {
+            out << "Error: Commit with ID or prefix '" << commitIdOrPrefix << "' not found.\n";
+            return;
+        }
+        if (result.status == Status::Ambiguous)
+        {
+            out << "Error: Ambiguous commit ID prefix '" << commitIdOrPrefix << "'.\n";
+            return;
+        }
+        if (result.status == Status::StorageError)
+        {
+            out << "Error: Could not record checkout of " << result.commitId.substr(0, 7) << ".\n";
+            return;
+        }
+        if (result.resolvedFromPrefix)
+        {
+            out << "Checking out full commit ID: " << result.commitId << "\n";
+        }
+        out << "HEAD is now at commit: " << result.commitId.substr(0, 7) << "\n";
+        if (result.stagingCleared)
+        {
+            out << "Warning: Staging area cleared due to checkout.\n";
+        }
+    }
 
-        while (!currentCommitId.empty())
+    void bundle(const char *action, const BundleResult &result)
+    {
+        if (notInitialized(result.status))
+            return;
+        if (result.status != Status::Ok)
         {
-            Commit *currentCommit = getCommit(currentCommitId); // Returns pointer
-            if (!currentCommit)
-            {
-                std::cerr << "Error: Commit data missing for ID: " << currentCommitId << std::endl;
-                break;
-            }
+            out << "Error: Bundle " << action << " failed: " << result.error << "\n";
+            return;
+        }
+        out << "Bundle " << action << ": " << result.commits << " commits, " << result.blobs << " blobs ("
+            << result.deltas << " as deltas)";
+        if (result.bytes > 0)
+            out << ", " << (size_t)result.bytes << " bytes";
+        out << "\n";
+    }
 
-            char timeBuf[80];
-            std::time_t commitTime = currentCommit->timestamp;
-            std::strftime(timeBuf, sizeof(timeBuf), "%a %b %d %H:%M:%S %Y %z", std::localtime(&commitTime));
+    void clone(const std::string &source, const CloneResult &result)
+    {
+        if (result.status == Status::AlreadyInitialized)
+        {
+            out << "Error: Cannot clone into an initialized repository.\n";
+            return;
+        }
+        if (result.status != Status::Ok)
+        {
+            out << "Error: Cannot clone '" << source << "': " << result.error << "\n";
+            return;
+        }
+        out << "Cloned '" << source << "': " << result.commits << " commits"
+            << (result.shallow ? " (shallow)" : "") << ", " << result.blobs << " blobs, HEAD "
+            << result.headCommitId.substr(0, 7) << "\n";
+    }
 
-            std::cout << "Commit: " << currentCommit->id << std::endl;
-            std::cout << "Date:   " << timeBuf << std::endl;
-            std::cout << "Message:" << currentCommit->message << std::endl;
-            std::cout << "Files:   ";
+    void fileState(const FileState &state)
+    {
+        if (state.status == Status::NotInitialized)
+        {
+            out << "Error: Repository not initialized.\n";
+            return;
+        }
+        out << "\n--- Files at HEAD (" << state.headCommitId.substr(0, 7) << ") ---\n";
+        if (state.status != Status::Ok)
+        {
+            out << "Error: Cannot get HEAD commit.\n";
+            return;
+        }
 
-            SimpleVec<std::string> trackedKeys = currentCommit->trackedFiles.getKeys();
-            if (trackedKeys.empty())
-            {
-                std::cout << "(none)" << std::endl;
-            }
+        if (state.tracked.empty())
+        {
+            out << "(No files tracked in this commit)\n";
+        }
+        for (size_t i = 0; i < state.tracked.size(); ++i)
+        {
+            const TrackedFile &file = state.tracked[i];
+            if (file.contentAvailable)
+                out << "'" << file.filename << "' : \"" << file.content << "\"\n";
+            else if (file.outsideSparse)
+                out << "'" << file.filename << "' : (outside sparse checkout)\n";
             else
+                out << "'" << file.filename << "' : (Error: Content blob " << file.contentHash << " not found!)\n";
+        }
+        out << "--------------------------\n";
+
+        if (!state.staged.empty())
+        {
+            out << "\n--- Staging Area ---\n";
+            for (size_t i = 0; i < state.staged.size(); ++i)
             {
-                bubbleSort(trackedKeys); // Sort for consistent output
-                bool first = true;
-                for (size_t i = 0; i < trackedKeys.size(); ++i)
-                {
-                    const std::string &fname = trackedKeys[i];
-                    const std::string *hashPtr = currentCommit->trackedFiles.find(fname);
-                    if (!first)
-                        std::cout << ", ";
-                    std::cout << fname;
-                    if (hashPtr)
-                        std::cout << " (" << hashPtr->substr(0, 6) << "...)";
-                    first = false;
-                }
-                std::cout << std::endl;
+                out << "Staged: '" << state.staged[i].filename << "' (Content Hash: "
+                    << state.staged[i].contentHash.substr(0, 6) << "...)\n";
             }
-
-            std::cout << "--------------------" << std::endl;
-            currentCommitId = currentCommit->parentId; // Move to parent
+            out << "--------------------\n";
+        }
+        else
+        {
+            out << "\n(Staging area is empty)\n\n";
         }
     }
+};
 
-    void checkout(const std::string &commitIdOrPrefix)
+#ifdef GITLET_HAS_COROUTINES
+
+// Eagerly started coroutine producing a T. Calling the coroutine runs it up
+// to its first suspension (typically a hop onto a pool), so several tasks
+// can be in flight before any of them is awaited. Whichever side finishes
+// second -- the body reaching its end, or the awaiter registering itself --
+// resumes the awaiter. A Task must be awaited before it is destroyed.
+template <typename T>
+class Task
+{
+public:
+    struct promise_type
     {
-        if (!initialized)
+        std::optional<T> value;
+        std::exception_ptr error;
+        std::atomic<void *> state; // nullptr: running, DONE: finished, else awaiter address
+
+        promise_type() : state(nullptr) {}
+
+        static void *doneMarker()
         {
-            std::cout << "Error: Repository not initialized. Run 'init' first." << std::endl;
-            return;
+            static char marker;
+            return &marker;
         }
 
-        std::string targetCommitId = "";
+        Task get_return_object()
+        {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
 
-        // Check for exact match first
-        if (commits.contains(commitIdOrPrefix))
+        std::suspend_never initial_suspend() noexcept
         {
-            targetCommitId = commitIdOrPrefix;
+            return {};
         }
-        else
+
+        struct FinalAwaiter
         {
-            // Try prefix matching
-            SimpleVec<std::string> allCommitIds = commits.getKeys();
-            int matchCount = 0;
-            for (size_t i = 0; i < allCommitIds.size(); ++i)
+            bool await_ready() noexcept
             {
-                const std::string &id = allCommitIds[i];
-                // Check if id starts with commitIdOrPrefix
-                if (id.rfind(commitIdOrPrefix, 0) == 0)
-                {
-                    matchCount++;
-                    targetCommitId = id; // Store potential match
-                }
+                return false;
             }
 
-            if (matchCount == 0)
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> self) noexcept
             {
-                std::cout << "Error: Commit with ID or prefix '" << commitIdOrPrefix << "' not found." << std::endl;
-                return;
-            }
-            else if (matchCount > 1)
-            {
-                std::cout << "Error: Ambiguous commit ID prefix '" << commitIdOrPrefix << "'." << std::endl;
-                return;
+                void *awaiter = self.promise().state.exchange(doneMarker(), std::memory_order_acq_rel);
+                return awaiter ? std::coroutine_handle<>::from_address(awaiter) : std::noop_coroutine();
             }
-            // Exactly one prefix match found, targetCommitId holds the full ID
-            std::cout << "Checking out full commit ID: " << targetCommitId << std::endl;
-        }
 
-        // Check if the target commit actually exists (should unless internal error)
-        if (!commits.contains(targetCommitId))
+            void await_resume() noexcept {}
+        };
+
+        FinalAwaiter final_suspend() noexcept
         {
-            std::cerr << "Critical Error: Target commit ID '" << targetCommitId << "' resolved but not found in map!" << std::endl;
-            return;
+            return {};
         }
 
-        headCommitId = targetCommitId;
-        std::cout << "HEAD is now at commit: " << headCommitId.substr(0, 7) << std::endl;
-
-        if (!stagingArea.empty())
+        void return_value(T result)
         {
-            std::cout << "Warning: Staging area cleared due to checkout." << std::endl;
-            stagingArea.clear();
+            value.emplace(std::move(result));
         }
-    }
 
-    void printCurrentFileState()
-    {
-        if (!initialized)
+        void unhandled_exception()
         {
-            std::cout << "Error: Repository not initialized." << std::endl;
-            return;
+            error = std::current_exception();
         }
-        std::cout << "\n--- Files at HEAD (" << headCommitId.substr(0, 7) << ") ---" << std::endl;
-        Commit *head = getHeadCommit();
-        if (!head)
+    };
+
+    struct Awaiter
+    {
+        std::coroutine_handle<promise_type> handle;
+
+        bool await_ready() const noexcept
         {
-            std::cerr << "Error: Cannot get HEAD commit." << std::endl;
-            return;
+            return handle.promise().state.load(std::memory_order_acquire) == promise_type::doneMarker();
         }
 
-        SimpleVec<std::string> trackedKeys = head->trackedFiles.getKeys();
-        if (trackedKeys.empty())
+        bool await_suspend(std::coroutine_handle<> awaiting) noexcept
         {
-            std::cout << "(No files tracked in this commit)" << std::endl;
+            void *expected = nullptr;
+            return handle.promise().state.compare_exchange_strong(expected, awaiting.address(), std::memory_order_acq_rel);
         }
-        else
+
+        T await_resume()
         {
-            bubbleSort(trackedKeys); // Sort for consistent output
-            for (size_t i = 0; i < trackedKeys.size(); ++i)
+            if (handle.promise().error)
             {
-                const std::string &filename = trackedKeys[i];
-                const std::string *contentHashPtr = head->trackedFiles.find(filename);
-                if (contentHashPtr)
-                {
-                    const std::string *contentPtr = objectStore.find(*contentHashPtr);
-                    if (contentPtr)
-                    {
-                        std::cout << "'" << filename << "' : \"" << *contentPtr << "\"" << std::endl;
-                    }
-                    else
-                    {
-                        std::cout << "'" << filename << "' : (Error: Content blob " << *contentHashPtr << " not found!)" << std::endl;
-                    }
-                }
-                else
-                {
-                    std::cout << "'" << filename << "' : (Error: Key inconsistency!)" << std::endl;
-                }
+                std::rethrow_exception(handle.promise().error);
             }
+            return std::move(*handle.promise().value);
         }
-        std::cout << "--------------------------" << std::endl;
+    };
 
-        SimpleVec<std::string> stagedKeys = stagingArea.getKeys();
-        if (!stagedKeys.empty())
+private:
+    std::coroutine_handle<promise_type> handle;
+
+    explicit Task(std::coroutine_handle<promise_type> h) : handle(h) {}
+
+public:
+    Task(Task &&other) noexcept : handle(other.handle)
+    {
+        other.handle = nullptr;
+    }
+
+    Task(const Task &) = delete;
+    Task &operator=(const Task &) = delete;
+
+    ~Task()
+    {
+        if (handle)
         {
-            std::cout << "\n--- Staging Area ---" << std::endl;
-            bubbleSort(stagedKeys); // Sort for consistent output
-            for (size_t i = 0; i < stagedKeys.size(); ++i)
-            {
-                const std::string &filename = stagedKeys[i];
-                const std::string *hashPtr = stagingArea.find(filename);
-                std::cout << "Staged: '" << filename << "' (Content Hash: ";
-                if (hashPtr)
-                    std::cout << hashPtr->substr(0, 6);
-                else
-                    std::cout << "???";
-                std::cout << "...)" << std::endl;
-            }
-            std::cout << "--------------------" << std::endl;
+            handle.destroy();
         }
-        else
+    }
+
+    Awaiter operator co_await() const noexcept
+    {
+        return Awaiter{handle};
+    }
+};
+
+// co_await scheduleOn(pool) continues the coroutine on one of pool's threads.
+struct ScheduleAwaiter
+{
+    ThreadPool &pool;
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        pool.submit([handle] { handle.resume(); });
+    }
+
+    void await_resume() const noexcept {}
+};
+
+inline ScheduleAwaiter scheduleOn(ThreadPool &pool)
+{
+    return ScheduleAwaiter{pool};
+}
+
+// Fire-and-forget coroutine; its frame frees itself on completion.
+struct DetachedTask
+{
+    struct promise_type
+    {
+        DetachedTask get_return_object()
+        {
+            return {};
+        }
+
+        std::suspend_never initial_suspend() noexcept
         {
-            std::cout << "\n(Staging area is empty)\n" << std::endl;
+            return {};
         }
+
+        std::suspend_never final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void return_void() {}
+
+        void unhandled_exception()
+        {
+            std::terminate();
+        }
+    };
+};
+
+template <typename T>
+struct SyncWaitState
+{
+    std::mutex mutex;
+    std::condition_variable finished;
+    bool done = false;
+    std::optional<T> value;
+    std::exception_ptr error;
+};
+
+template <typename T>
+DetachedTask runAndSignal(Task<T> &task, SyncWaitState<T> &state)
+{
+    std::optional<T> value;
+    std::exception_ptr error;
+    try
+    {
+        value.emplace(co_await task);
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.value = std::move(value);
+    state.error = error;
+    state.done = true;
+    state.finished.notify_one();
+}
+
+// Blocks the calling thread until task completes; for code outside an event
+// loop (such as main) that still wants to drive the async API.
+template <typename T>
+T syncWait(Task<T> task)
+{
+    SyncWaitState<T> state;
+    runAndSignal(task, state);
+    std::unique_lock<std::mutex> lock(state.mutex);
+    state.finished.wait(lock, [&state] { return state.done; });
+    if (state.error)
+    {
+        std::rethrow_exception(state.error);
+    }
+    return std::move(*state.value);
+}
+
+// Awaitable front end for a Gitlet. Content hashing runs on the CPU pool, so
+// many in-flight adds hash in parallel; everything that touches repository state
+// or the log runs on the I/O pool under one lock, which keeps the
+// (single-threaded) Gitlet and its caches consistent. Results are the
+// structured values of the core operations, never console text. Operations
+// that must be ordered (an add and the commit that should include it) are
+// ordered by awaiting them in turn.
+class AsyncGitlet
+{
+private:
+    Gitlet &repo;
+    ThreadPool &cpuPool;
+    ThreadPool &ioPool;
+    std::mutex repoMutex;
+
+public:
+    AsyncGitlet(Gitlet &r, ThreadPool &cpu, ThreadPool &io) : repo(r), cpuPool(cpu), ioPool(io) {}
+
+    Task<AddResult> add(std::string filename, std::string content)
+    {
+        co_await scheduleOn(cpuPool);
+        std::string contentHash = Gitlet::hashContent(content);
+        co_await scheduleOn(ioPool);
+        std::lock_guard<std::mutex> lock(repoMutex);
+        co_return repo.stageFile(filename, content, contentHash);
+    }
+
+    Task<CommitResult> commit(std::string message)
+    {
+        co_await scheduleOn(ioPool);
+        std::lock_guard<std::mutex> lock(repoMutex);
+        co_return repo.commit(message);
+    }
+
+    Task<SimpleVec<LogEntry>> log(LogOptions options)
+    {
+        co_await scheduleOn(ioPool);
+        SimpleVec<LogEntry> entries;
+        std::lock_guard<std::mutex> lock(repoMutex);
+        repo.collectLog(options, entries);
+        co_return entries;
+    }
+
+    Task<CheckoutResult> checkout(std::string commitIdOrPrefix)
+    {
+        co_await scheduleOn(ioPool);
+        std::lock_guard<std::mutex> lock(repoMutex);
+        co_return repo.checkout(commitIdOrPrefix);
+    }
+
+    Task<bool> sync()
+    {
+        co_await scheduleOn(ioPool);
+        std::lock_guard<std::mutex> lock(repoMutex);
+        co_return repo.sync();
     }
 };
 
+#endif // GITLET_HAS_COROUTINES
+
 // --- Main Function (Example Usage - Should work as before) ---
 int main()
 {
+    OutputSink out(std::cout);
+    ConsoleRenderer render(out);
     Gitlet repo;
 
-    std::cout << ">>> repo.init();\n";
-    repo.init();                                 // Need to capture the ID printed here
+    out << ">>> repo.init();\n";
+    render.init(repo.init());                    // Need to capture the ID printed here
     std::string initialCommitId = "PLACEHOLDER"; // *** MANUALLY UPDATE THIS AFTER FIRST RUN ***
-    repo.printCurrentFileState();
+    render.fileState(repo.fileState());
 
-    std::cout << "\n>>> repo.add(\"file1.txt\", \"Hello\");\n";
-    repo.add("file1.txt", "Hello");
-    repo.printCurrentFileState();
+    out << "\n>>> repo.add(\"file1.txt\", \"Hello\");\n";
+    render.add("file1.txt", repo.add("file1.txt", "Hello"));
+    render.fileState(repo.fileState());
 
-    std::cout << "\n>>> repo.commit(\"Add file1.txt\");\n";
-    repo.commit("Add file1.txt");
-    repo.printCurrentFileState();
+    out << "\n>>> repo.commit(\"Add file1.txt\");\n";
+    render.commit(repo.commit("Add file1.txt"));
+    render.fileState(repo.fileState());
 
-    std::cout << "\n>>> repo.add(\"file1.txt\", \"Hello World!\");\n";
-    repo.add("file1.txt", "Hello World!");
-    std::cout << "\n>>> repo.add(\"file2.txt\", \"Another file.\");\n";
-    repo.add("file2.txt", "Another file.");
-    repo.printCurrentFileState();
+    out << "\n>>> repo.add(\"file1.txt\", \"Hello World!\");\n";
+    render.add("file1.txt", repo.add("file1.txt", "Hello World!"));
+    out << "\n>>> repo.add(\"file2.txt\", \"Another file.\");\n";
+    render.add("file2.txt", repo.add("file2.txt", "Another file."));
+    render.fileState(repo.fileState());
 
-    std::cout << "\n>>> repo.commit(\"Update file1, add file2\");\n";
-    repo.commit("Update file1, add file2");
-    repo.printCurrentFileState();
+    out << "\n>>> repo.commit(\"Update file1, add file2\");\n";
+    render.commit(repo.commit("Update file1, add file2"));
+    render.fileState(repo.fileState());
 
-    std::cout << "\n>>> repo.add(\"file1.txt\", \"Hello World!\"); // Add identical content\n";
-    repo.add("file1.txt", "Hello World!");
-    repo.printCurrentFileState();
+    out << "\n>>> repo.add(\"file1.txt\", \"Hello World!\"); // Add identical content\n";
+    render.add("file1.txt", repo.add("file1.txt", "Hello World!"));
+    render.fileState(repo.fileState());
 
-    std::cout << "\n>>> repo.log();\n";
-    repo.log();
+    out << "\n>>> repo.log();\n";
+    render.log(repo.log());
 
-    std::cout << "\n>>> repo.checkout(...); // Using prefix of initial commit\n";
-    std::cout << "!! Important: Update 'initialCommitId' variable above with the actual hash from the 'init' output, then uncomment checkout below !!" << std::endl;
+    out << "\n>>> repo.checkout(...); // Using prefix of initial commit\n";
+    out << "!! Important: Update 'initialCommitId' variable above with the actual hash from the 'init' output, then uncomment checkout below !!\n";
     // if (initialCommitId != "PLACEHOLDER") {
-    //     repo.checkout(initialCommitId.substr(0, 6)); // Use a prefix
-    //     repo.printCurrentFileState();
+    //     render.checkout(initialCommitId.substr(0, 6), repo.checkout(initialCommitId.substr(0, 6))); // Use a prefix
+    //     render.fileState(repo.fileState());
     // } else {
-    //    std::cout << "Skipping checkout test as initial commit ID was not updated." << std::endl;
+    //    out << "Skipping checkout test as initial commit ID was not updated.\n";
     // }
 
-    std::cout << "\n>>> repo.log(); // Log from the checked-out state (if checkout ran)\n";
-    repo.log();
+    out << "\n>>> repo.log(); // Log from the checked-out state (if checkout ran)\n";
+    render.log(repo.log());
 
     return 0;
-}
\ No newline at end of file
+}
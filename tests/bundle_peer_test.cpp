@@ -0,0 +1,327 @@
+// Bundle round trip against a stand-in peer process.
+//
+// The peer is a forked child that owns the sending repository and streams
+// bundles to the parent over a pipe; the parent imports them. Covers a full
+// bundle into an empty repository (a clone), an incremental bundle after new
+// commits, rejection of a corrupted stream, bundles into a blobless clone and
+// out of a shallow one, clones of a blobless clone, and a sparse clone from a
+// relative path.
+//
+// Build and run from the repository root:
+//   g++ -std=c++17 -O2 -pthread tests/bundle_peer_test.cpp -o bundle_peer_test && ./bundle_peer_test
+
+#define main gitlet_demo_main
+#include "../main.cpp"
+#undef main
+
+#include <sys/wait.h>
+#include <cstdlib>
+
+static int failures = 0;
+
+#define CHECK(condition)                                                         \
+    do                                                                           \
+    {                                                                            \
+        if (!(condition))                                                        \
+        {                                                                        \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, \
+                         #condition);                                            \
+            failures++;                                                          \
+        }                                                                        \
+    } while (0)
+
+// Minimal unbuffered-ish stream buffer over a pipe end.
+class FdStreamBuf : public std::streambuf
+{
+private:
+    int fd;
+    char buffer[4096];
+
+protected:
+    int_type underflow() override
+    {
+        ssize_t n;
+        do
+        {
+            n = ::read(fd, buffer, sizeof(buffer));
+        } while (n < 0 && errno == EINTR);
+        if (n <= 0)
+        {
+            return traits_type::eof();
+        }
+        setg(buffer, buffer, buffer + n);
+        return traits_type::to_int_type(buffer[0]);
+    }
+
+    int_type overflow(int_type c) override
+    {
+        if (sync() != 0)
+        {
+            return traits_type::eof();
+        }
+        if (c != traits_type::eof())
+        {
+            *pptr() = (char)c;
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+
+    int sync() override
+    {
+        const char *data = pbase();
+        size_t left = (size_t)(pptr() - pbase());
+        while (left > 0)
+        {
+            ssize_t n = ::write(fd, data, left);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                return -1;
+            data += n;
+            left -= (size_t)n;
+        }
+        setp(buffer, buffer + sizeof(buffer) - 1);
+        return 0;
+    }
+
+public:
+    FdStreamBuf(int descriptor, bool writing) : fd(descriptor)
+    {
+        if (writing)
+            setp(buffer, buffer + sizeof(buffer) - 1);
+        else
+            setg(buffer, buffer, buffer);
+    }
+};
+
+enum PeerMode
+{
+    SEND_INTACT,
+    SEND_CORRUPT
+};
+
+// Forks a peer that exports range from sender into a pipe and exits; the
+// parent imports from the other end into receiver.
+static BundleResult importFromPeer(Gitlet &sender, const BundleRange &range, Gitlet &receiver, PeerMode mode)
+{
+    int fds[2];
+    if (::pipe(fds) != 0)
+    {
+        BundleResult failed;
+        failed.status = Status::StorageError;
+        failed.error = "pipe failed";
+        return failed;
+    }
+    pid_t pid = ::fork();
+    if (pid == 0)
+    {
+        ::close(fds[0]);
+        FdStreamBuf buf(fds[1], true);
+        std::ostream out(&buf);
+        if (mode == SEND_CORRUPT)
+        {
+            std::ostringstream bundle;
+            sender.exportBundle(bundle, range);
+            std::string bytes = bundle.str();
+            bytes[bytes.size() / 2] ^= 0x40;
+            out.write(bytes.data(), (std::streamsize)bytes.size());
+        }
+        else
+        {
+            sender.exportBundle(out, range);
+        }
+        out.flush();
+        ::close(fds[1]);
+        ::_exit(0);
+    }
+    ::close(fds[1]);
+    FdStreamBuf buf(fds[0], false);
+    std::istream in(&buf);
+    BundleResult result = receiver.importBundle(in);
+    ::close(fds[0]);
+    ::waitpid(pid, nullptr, 0);
+    return result;
+}
+
+static void commitFiles(Gitlet &repo, int first, int count)
+{
+    std::string body;
+    for (int line = 0; line < 200; ++line)
+    {
+        body += "line " + std::to_string(line) + " of a tracked file\n";
+    }
+    for (int i = first; i < first + count; ++i)
+    {
+        repo.add("src/file" + std::to_string(i % 4), body + "revision " + std::to_string(i) + "\n");
+        repo.add("notes.txt", "note " + std::to_string(i));
+        repo.commit("commit " + std::to_string(i));
+    }
+}
+
+static bool sameHistory(Gitlet &a, Gitlet &b)
+{
+    SimpleVec<LogEntry> left, right;
+    if (a.collectLog(LogOptions(), left) != Status::Ok || b.collectLog(LogOptions(), right) != Status::Ok ||
+        left.size() != right.size())
+    {
+        return false;
+    }
+    for (size_t i = 0; i < left.size(); ++i)
+    {
+        if (left[i].id != right[i].id || left[i].files.size() != right[i].files.size())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool allContentAvailable(Gitlet &repo)
+{
+    FileState files = repo.fileState();
+    for (size_t i = 0; i < files.tracked.size(); ++i)
+    {
+        if (!files.tracked[i].contentAvailable)
+        {
+            return false;
+        }
+    }
+    return !files.tracked.empty();
+}
+
+int main()
+{
+    Gitlet sender;
+    sender.init();
+    commitFiles(sender, 0, 40);
+
+    // Full bundle into an empty repository.
+    Gitlet receiver;
+    BundleResult full = importFromPeer(sender, BundleRange(), receiver, SEND_INTACT);
+    CHECK(full.status == Status::Ok);
+    CHECK(full.commits == 41);
+    CHECK(full.deltas > 0);
+    CHECK(receiver.fileState().headCommitId == sender.fileState().headCommitId);
+    CHECK(sameHistory(sender, receiver));
+
+    // Incremental bundle: only commits the receiver lacks travel.
+    commitFiles(sender, 40, 5);
+    BundleRange range;
+    range.haves = receiver.advertiseHaves();
+    BundleResult incremental = importFromPeer(sender, range, receiver, SEND_INTACT);
+    CHECK(incremental.status == Status::Ok);
+    CHECK(incremental.commits == 5);
+    CheckoutResult moved = receiver.checkout(sender.fileState().headCommitId);
+    CHECK(moved.status == Status::Ok);
+    CHECK(sameHistory(sender, receiver));
+    FileState files = receiver.fileState();
+    CHECK(files.tracked.size() == 5);
+    for (size_t i = 0; i < files.tracked.size(); ++i)
+    {
+        CHECK(files.tracked[i].contentAvailable);
+    }
+
+    // A corrupted stream is rejected.
+    Gitlet victim;
+    BundleResult corrupt = importFromPeer(sender, BundleRange(), victim, SEND_CORRUPT);
+    CHECK(corrupt.status == Status::StorageError);
+    CHECK(!corrupt.error.empty());
+    CHECK(victim.init().status == Status::Ok); // never adopted a HEAD
+
+    // Partial and shallow clones need on-disk repositories.
+    char scratch[] = "/tmp/bundle_peer_test.XXXXXX";
+    CHECK(::mkdtemp(scratch) != nullptr);
+    std::string dir = scratch;
+    {
+        Gitlet origin;
+        CHECK(origin.open(dir + "/origin").status == Status::Ok);
+        origin.init();
+        commitFiles(origin, 0, 20);
+
+        // An incremental bundle into a blobless clone: delta bases and blobs
+        // the sender assumes come from the backing store.
+        Gitlet blobless;
+        CHECK(blobless.open(dir + "/blobless").status == Status::Ok);
+        CloneOptions lazy;
+        lazy.blobless = true;
+        CHECK(blobless.clone(dir + "/origin", lazy).status == Status::Ok);
+
+        // Clones of the blobless clone fetch through its backing store and
+        // leave its log as it was.
+        std::string partialLog;
+        CHECK(readWholeFile(dir + "/blobless/log", partialLog));
+        Gitlet fullOfPartial;
+        CHECK(fullOfPartial.open(dir + "/full-of-partial").status == Status::Ok);
+        CloneResult copied = fullOfPartial.clone(dir + "/blobless");
+        CHECK(copied.status == Status::Ok);
+        CHECK(copied.blobs > 0);
+        CHECK(allContentAvailable(fullOfPartial));
+        Gitlet lazyOfPartial;
+        CHECK(lazyOfPartial.open(dir + "/lazy-of-partial").status == Status::Ok);
+        CHECK(lazyOfPartial.clone(dir + "/blobless", lazy).status == Status::Ok);
+        CHECK(allContentAvailable(lazyOfPartial));
+        std::string partialLogAfter;
+        CHECK(readWholeFile(dir + "/blobless/log", partialLogAfter));
+        CHECK(partialLogAfter == partialLog);
+        Gitlet upstream;
+        CHECK(upstream.open(dir + "/upstream").status == Status::Ok);
+        CHECK(upstream.clone(dir + "/origin").status == Status::Ok);
+        commitFiles(upstream, 20, 3);
+        BundleRange haves;
+        haves.haves = blobless.advertiseHaves();
+        BundleResult intoPartial = importFromPeer(upstream, haves, blobless, SEND_INTACT);
+        CHECK(intoPartial.status == Status::Ok);
+        CHECK(intoPartial.commits == 3);
+        CHECK(intoPartial.deltas > 0);
+        CHECK(blobless.checkout(upstream.fileState().headCommitId).status == Status::Ok);
+        CHECK(sameHistory(upstream, blobless));
+
+        // A sparse clone from a relative path: "src/" means the src directory,
+        // and the saved source still resolves from another directory.
+        char cwd[4096];
+        CHECK(::getcwd(cwd, sizeof(cwd)) != nullptr);
+        {
+            CHECK(::chdir(dir.c_str()) == 0);
+            Gitlet sparse;
+            CHECK(sparse.open("sparse").status == Status::Ok);
+            CloneOptions srcOnly;
+            srcOnly.blobless = true;
+            srcOnly.sparsePaths.push_back("src/");
+            CHECK(sparse.clone("origin", srcOnly).status == Status::Ok);
+            CHECK(::chdir("/") == 0);
+        }
+        Gitlet sparse;
+        CHECK(sparse.open(dir + "/sparse").status == Status::Ok);
+        FileState sparseFiles = sparse.fileState();
+        CHECK(sparseFiles.tracked.size() == 5);
+        for (size_t i = 0; i < sparseFiles.tracked.size(); ++i)
+        {
+            bool underSrc = sparseFiles.tracked[i].filename.rfind("src/", 0) == 0;
+            CHECK(sparseFiles.tracked[i].outsideSparse == !underSrc);
+            CHECK(sparseFiles.tracked[i].contentAvailable == underSrc);
+        }
+        CHECK(::chdir(cwd) == 0);
+
+        // A bundle out of a shallow clone carries its shallow root.
+        Gitlet shallow;
+        CHECK(shallow.open(dir + "/shallow").status == Status::Ok);
+        CloneOptions recent;
+        recent.depth = 5;
+        CHECK(shallow.clone(dir + "/origin", recent).status == Status::Ok);
+        Gitlet fromShallow;
+        BundleResult shallowBundle = importFromPeer(shallow, BundleRange(), fromShallow, SEND_INTACT);
+        CHECK(shallowBundle.status == Status::Ok);
+        CHECK(shallowBundle.commits == 5);
+        CHECK(sameHistory(shallow, fromShallow));
+    }
+    std::system(("rm -rf " + dir).c_str());
+
+    if (failures == 0)
+    {
+        std::printf("bundle_peer_test: all checks passed\n");
+        return 0;
+    }
+    std::printf("bundle_peer_test: %d check(s) failed\n", failures);
+    return 1;
+}
@@ -0,0 +1,155 @@
+// Crash recovery of an on-disk repository.
+//
+// Damages the write-ahead log the way a crash or bad disk would and checks
+// what open() makes of it: a torn tail past the published HEAD is cut off and
+// history is recovered, while damage inside the part HEAD records as durable
+// fails the open and leaves the file untouched.
+//
+// Build and run from the repository root:
+//   g++ -std=c++17 -O2 -pthread tests/recovery_test.cpp -o recovery_test && ./recovery_test
+
+#define main gitlet_demo_main
+#include "../main.cpp"
+#undef main
+
+#include <cstdlib>
+#include <fstream>
+
+static int failures = 0;
+
+#define CHECK(condition)                                                         \
+    do                                                                           \
+    {                                                                            \
+        if (!(condition))                                                        \
+        {                                                                        \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, \
+                         #condition);                                            \
+            failures++;                                                          \
+        }                                                                        \
+    } while (0)
+
+static std::string makeRepository(const std::string &dir, int commitCount)
+{
+    Gitlet repo;
+    CHECK(repo.open(dir).status == Status::Ok);
+    CHECK(repo.init().status == Status::Ok);
+    for (int i = 0; i < commitCount; ++i)
+    {
+        repo.add("file" + std::to_string(i % 3), "revision " + std::to_string(i));
+        CHECK(repo.commit("commit " + std::to_string(i)).status == Status::Ok);
+    }
+    return repo.fileState().headCommitId;
+}
+
+static std::string readLog(const std::string &dir)
+{
+    std::string bytes;
+    CHECK(readWholeFile(dir + "/log", bytes));
+    return bytes;
+}
+
+static void writeLog(const std::string &dir, const std::string &bytes)
+{
+    std::ofstream out(dir + "/log", std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), (std::streamsize)bytes.size());
+}
+
+// Offset of the index-th (0-based) record: frames are
+// [u32 payload length][u32 crc][u8 type][payload].
+static size_t recordOffset(const std::string &log, int index)
+{
+    size_t pos = 0;
+    for (int i = 0; i < index; ++i)
+    {
+        std::string lengthField = log.substr(pos, 4);
+        ByteReader reader(lengthField);
+        pos += 9 + reader.readU32();
+    }
+    return pos;
+}
+
+static size_t historyLength(Gitlet &repo)
+{
+    SimpleVec<LogEntry> entries;
+    repo.collectLog(LogOptions(), entries);
+    return entries.size();
+}
+
+int main()
+{
+    char scratch[] = "/tmp/recovery_test.XXXXXX";
+    CHECK(::mkdtemp(scratch) != nullptr);
+    std::string dir = scratch;
+
+    // A torn tail after the published HEAD is cut off; history survives.
+    {
+        std::string repoDir = dir + "/torn";
+        std::string head = makeRepository(repoDir, 30);
+        std::string intact = readLog(repoDir);
+        writeLog(repoDir, intact + std::string("\x40\x00\x00", 3));
+
+        Gitlet repo;
+        OpenResult opened = repo.open(repoDir);
+        CHECK(opened.status == Status::Ok);
+        CHECK(opened.recovered);
+        CHECK(opened.discardedBytes == 3);
+        CHECK(!opened.logShorterThanHead);
+        CHECK(opened.headCommitId == head);
+        CHECK(historyLength(repo) == 31);
+        CHECK(readLog(repoDir) == intact);
+        CHECK(repo.init().status == Status::AlreadyInitialized);
+    }
+
+    // A bad frame inside the durable prefix fails the open and touches nothing.
+    {
+        std::string repoDir = dir + "/corrupt";
+        makeRepository(repoDir, 30);
+        std::string damaged = readLog(repoDir);
+        damaged[recordOffset(damaged, 2)] ^= 0x01; // third record's length field
+        writeLog(repoDir, damaged);
+
+        Gitlet repo;
+        OpenResult opened = repo.open(repoDir);
+        CHECK(opened.status == Status::StorageError);
+        CHECK(!opened.error.empty());
+        CHECK(!opened.recovered);
+        CHECK(readLog(repoDir) == damaged);
+
+        // The failed repository is detached: new history stays in memory.
+        CHECK(repo.init().status == Status::Ok);
+        repo.add("new.txt", "new");
+        CHECK(repo.commit("unrelated").status == Status::Ok);
+        CHECK(readLog(repoDir) == damaged);
+
+        Gitlet reader;
+        CHECK(reader.openReadOnly(repoDir).status == Status::StorageError);
+        Gitlet again;
+        CHECK(again.open(repoDir).status == Status::StorageError);
+        CHECK(readLog(repoDir) == damaged);
+    }
+
+    // A log cut short below the published size is damage too, not a torn tail.
+    {
+        std::string repoDir = dir + "/short";
+        makeRepository(repoDir, 10);
+        std::string log = readLog(repoDir);
+        std::string shortened = log.substr(0, recordOffset(log, 5));
+        writeLog(repoDir, shortened);
+
+        Gitlet repo;
+        OpenResult opened = repo.open(repoDir);
+        CHECK(opened.status == Status::StorageError);
+        CHECK(opened.logShorterThanHead);
+        CHECK(readLog(repoDir) == shortened);
+    }
+
+    std::system(("rm -rf " + dir).c_str());
+
+    if (failures == 0)
+    {
+        std::printf("recovery_test: all checks passed\n");
+        return 0;
+    }
+    std::printf("recovery_test: %d check(s) failed\n", failures);
+    return 1;
+}